@@ -0,0 +1,138 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "ReindeerLib/ActivityFile.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	// A run near Greenwich, written and read back as GPX text would be
+	std::vector<GpxPoint> createGpxData(size_t n, std::string &gpx)
+	{
+		std::mt19937 randomEng(0);
+		std::uniform_real_distribution<double> randomStep(-2e-5, 3e-5);
+		std::uniform_real_distribution<double> randomClimb(-0.5, 0.5);
+		std::uniform_int_distribution<uint64_t> randomTime_ms(900, 1100);
+
+		std::vector<GpxPoint> gpxData;
+		double longitude = -0.01, latitude = 51.47, elevation_m = 12.0;
+		uint64_t dateTime_ms = 1559374200000;
+		for (size_t i = 0; i < n; ++i)
+		{
+			char text[256];
+			std::snprintf(text, sizeof(text), "%.7f %.7f %.2f", longitude, latitude, elevation_m);
+
+			char *end;
+			const auto lon = std::strtod(text, &end);
+			const auto lat = std::strtod(end, &end);
+			const auto ele = std::strtod(end, &end);
+			gpxData.emplace_back(lon, lat, ele, dateTime_ms);
+
+			std::snprintf(text, sizeof(text),
+				"<trkpt lat=\"%.7f\" lon=\"%.7f\"><ele>%.2f</ele><time>2019-06-01T07:30:00.000Z</time></trkpt>\n", lat, lon, ele);
+			gpx += text;
+
+			longitude += randomStep(randomEng);
+			latitude += randomStep(randomEng);
+			elevation_m += randomClimb(randomEng);
+			dateTime_ms += randomTime_ms(randomEng);
+		}
+
+		return gpxData;
+	}
+
+	void assertGpxDataEqual(const std::vector<GpxPoint> &expected, const std::vector<GpxPoint> &actual)
+	{
+		Assert::AreEqual(expected.size(), actual.size(), L"Unexpected number of points");
+		for (size_t i = 0; i < expected.size(); ++i)
+		{
+			Assert::AreEqual(expected[i].longitude, actual[i].longitude, L"Longitude differs");
+			Assert::AreEqual(expected[i].latitude, actual[i].latitude, L"Latitude differs");
+			Assert::AreEqual(expected[i].elevation_m, actual[i].elevation_m, L"Elevation differs");
+			Assert::AreEqual(expected[i].dateTime_ms, actual[i].dateTime_ms, L"Time differs");
+		}
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(ActivityFileTests)
+	{
+	public:
+
+		TEST_METHOD(EncodeDecodeRoundTrip)
+		{
+			std::string gpx;
+			const auto gpxData = createGpxData(10000, gpx);
+			const auto encoded = encodeActivity(gpxData);
+			assertGpxDataEqual(gpxData, decodeActivity(encoded.data(), encoded.size()));
+
+			const auto summary = decodeActivitySummary(encoded.data(), encoded.size());
+			Assert::AreEqual(uint64_t(gpxData.size()), summary.nPoints);
+			for (const auto &p : gpxData)
+			{
+				Assert::IsTrue(summary.minLongitude <= p.longitude && p.longitude <= summary.maxLongitude, L"Longitude outside bounds");
+				Assert::IsTrue(summary.minLatitude <= p.latitude && p.latitude <= summary.maxLatitude, L"Latitude outside bounds");
+			}
+
+			Assert::IsTrue(10 * encoded.size() < gpx.size(), L"Encoding should be at least 10x smaller than GPX");
+
+			const auto empty = encodeActivity({});
+			Assert::AreEqual(size_t(0), decodeActivity(empty.data(), empty.size()).size());
+		}
+
+		TEST_METHOD(ValuesAreQuantized)
+		{
+			const std::vector<GpxPoint> gpxData = { GpxPoint(-0.123456789, 51.5, 12.345, 1), GpxPoint(179.9999999, -89.9, -400.0, 0) };
+			const auto encoded = encodeActivity(gpxData);
+			const auto decoded = decodeActivity(encoded.data(), encoded.size());
+
+			Assert::AreEqual(-0.1234568, decoded[0].longitude);
+			Assert::AreEqual(12.35, decoded[0].elevation_m);
+			Assert::AreEqual(179.9999999, decoded[1].longitude);
+			Assert::AreEqual(uint64_t(0), decoded[1].dateTime_ms);
+
+			Assert::ExpectException<std::invalid_argument>([]() { encodeActivity({ GpxPoint(std::nan(""), 0.0, 0.0, 0) }); });
+		}
+
+		TEST_METHOD(InvalidDataThrows)
+		{
+			std::string gpx;
+			const auto encoded = encodeActivity(createGpxData(100, gpx));
+
+			Assert::ExpectException<std::runtime_error>([&encoded]() { decodeActivity(encoded.data(), 10); });
+			Assert::ExpectException<std::runtime_error>([&encoded]() { decodeActivity(encoded.data(), encoded.size() - 1); });
+
+			auto badMagic = encoded;
+			badMagic[0] ^= 1;
+			Assert::ExpectException<std::runtime_error>([&badMagic]() { decodeActivity(badMagic.data(), badMagic.size()); });
+
+			// An unterminated varint at the end of the time column
+			auto truncated = encoded;
+			truncated.back() = static_cast<char>(0x80);
+			Assert::ExpectException<std::runtime_error>([&truncated]() { decodeActivity(truncated.data(), truncated.size()); });
+		}
+
+		TEST_METHOD(ReadWriteActivityFile)
+		{
+			std::string gpx;
+			const auto gpxData = createGpxData(1000, gpx);
+
+			const auto path = std::filesystem::temp_directory_path() / L"ReadWriteActivityFile.act";
+			writeActivityFile(path.wstring(), gpxData);
+			Assert::AreEqual(uint64_t(gpxData.size()), readActivitySummary(path.wstring()).nPoints);
+			assertGpxDataEqual(gpxData, readActivityFile(path.wstring()));
+			std::filesystem::remove(path);
+		}
+	};
+}
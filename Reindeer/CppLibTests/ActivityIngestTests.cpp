@@ -0,0 +1,150 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "ReindeerLib/ActivityColumns.h"
+#include "ReindeerLib/ActivityIngest.h"
+#include "ReindeerLib/GpxParser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	// A GPX file of a run of nPoints, with a point a second
+	std::string createGpx(size_t nPoints, unsigned seed)
+	{
+		std::mt19937 randomEng(seed);
+		std::uniform_real_distribution<double> randomStep(0.0, 5e-5);
+		std::uniform_real_distribution<double> randomClimb(-0.5, 0.5);
+
+		std::string gpx = "<gpx><trk><trkseg>\n";
+		double longitude = -0.01, latitude = 51.47, elevation_m = 12.0;
+		for (size_t i = 0; i < nPoints; ++i)
+		{
+			char text[256];
+			std::snprintf(text, sizeof(text),
+				"<trkpt lat=\"%.7f\" lon=\"%.7f\"><ele>%.1f</ele><time>2019-06-01T%02zu:%02zu:%02zuZ</time></trkpt>\n",
+				latitude, longitude, elevation_m, i / 3600, i / 60 % 60, i % 60);
+			gpx += text;
+
+			longitude += randomStep(randomEng);
+			latitude += randomStep(randomEng);
+			elevation_m += randomClimb(randomEng);
+		}
+
+		return gpx + "</trkseg></trk></gpx>";
+	}
+
+	std::vector<std::wstring> writeGpxFiles(size_t nFiles)
+	{
+		std::vector<std::wstring> paths;
+		for (size_t i = 0; i < nFiles; ++i)
+		{
+			const auto path = std::filesystem::temp_directory_path() / (L"IngestActivity" + std::to_wstring(i) + L".gpx");
+			std::ofstream file(path, std::ios::binary);
+			file << createGpx(500 + 100 * i, static_cast<unsigned>(i));
+			paths.push_back(path.wstring());
+		}
+
+		return paths;
+	}
+
+	void removeFiles(const std::vector<std::wstring> &paths)
+	{
+		for (const auto &path : paths)
+			std::filesystem::remove(path);
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(ActivityIngestTests)
+	{
+	public:
+
+		TEST_METHOD(IngestMatchesSerial)
+		{
+			const auto paths = writeGpxFiles(12);
+
+			IngestOptions options;
+			options.nReadThreads = 2;
+			options.nParseThreads = 3;
+			options.nAnalysisThreads = 2;
+			options.queueCapacity = 1;
+
+			IngestStats stats;
+			const auto activities = ingestActivities(paths, options, &stats);
+			Assert::AreEqual(paths.size(), activities.size(), L"Unexpected number of activities");
+
+			for (size_t i = 0; i < paths.size(); ++i)
+			{
+				const auto gpxData = readGpxFile(paths[i]);
+				const auto expected = calculatePaceCurve(ActivityColumns::fromGpx(gpxData),
+					options.min_m, options.resolution_m, options.minElevationDiff_m);
+
+				const auto &activity = activities[i];
+				Assert::IsTrue(activity.error.empty(), L"Unexpected error");
+				Assert::IsTrue(activity.path == paths[i], L"Activities out of order");
+				Assert::AreEqual(gpxData.size(), activity.nPoints);
+				Assert::AreEqual(expected.size(), activity.paceCurve.size(), L"Pace curve sizes differ");
+				for (size_t j = 0; j < expected.size(); ++j)
+				{
+					Assert::AreEqual(expected[j].bestPaceSegment.distanceTime.distance_m, activity.paceCurve[j].bestPaceSegment.distanceTime.distance_m);
+					Assert::AreEqual(expected[j].bestPaceSegment.distanceTime.time_s, activity.paceCurve[j].bestPaceSegment.distanceTime.time_s);
+				}
+			}
+
+			Assert::AreEqual(paths.size(), stats.read.nFiles);
+			Assert::AreEqual(paths.size(), stats.parse.nFiles);
+			Assert::AreEqual(paths.size(), stats.analysis.nFiles);
+			Assert::AreEqual(stats.parse.nPoints, stats.analysis.nPoints);
+			Assert::AreEqual(stats.read.nBytes, stats.parse.nBytes);
+
+			for (const auto &stage : { std::make_pair("read", stats.read), std::make_pair("parse", stats.parse), std::make_pair("analysis", stats.analysis) })
+			{
+				char message[256];
+				std::snprintf(message, sizeof(message), "%s: %u threads, %zu files, %.1f MB, %llu points, %.3f s busy, %.0f%% utilised",
+					stage.first, stage.second.nThreads, stage.second.nFiles, stage.second.nBytes / 1e6, static_cast<unsigned long long>(stage.second.nPoints),
+					stage.second.busyTime_s, 100.0 * stage.second.utilisation(stats.elapsed_s));
+				Logger::WriteMessage(message);
+			}
+
+			removeFiles(paths);
+		}
+
+		TEST_METHOD(FailedFilesReportErrors)
+		{
+			auto paths = writeGpxFiles(3);
+			paths.insert(paths.begin() + 1, (std::filesystem::temp_directory_path() / L"IngestActivityMissing.gpx").wstring());
+
+			const auto invalidPath = std::filesystem::temp_directory_path() / L"IngestActivityInvalid.gpx";
+			{
+				std::ofstream file(invalidPath, std::ios::binary);
+				file << "<trkpt lat=\"x\" lon=\"1\"/>";
+			}
+			paths.push_back(invalidPath.wstring());
+
+			IngestOptions options;
+			options.nReadThreads = 1;
+			options.nParseThreads = 1;
+			options.nAnalysisThreads = 1;
+
+			const auto activities = ingestActivities(paths, options);
+			Assert::AreEqual(size_t(5), activities.size(), L"Unexpected number of activities");
+			Assert::IsTrue(activities[0].error.empty() && !activities[0].paceCurve.empty(), L"Valid file should be ingested");
+			Assert::IsFalse(activities[1].error.empty(), L"Missing file should report an error");
+			Assert::IsTrue(activities[2].error.empty() && !activities[2].paceCurve.empty(), L"Valid file should be ingested");
+			Assert::IsFalse(activities[4].error.empty(), L"Invalid file should report an error");
+
+			removeFiles(paths);
+			Assert::AreEqual(size_t(0), ingestActivities({}, options).size());
+		}
+	};
+}
@@ -0,0 +1,175 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "ReindeerLib/ActivitySpatialIndex.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	// Random walks starting around a town, so that activities cross each other
+	std::vector<std::vector<GpxPoint>> createActivities(size_t nActivities, size_t nPoints)
+	{
+		std::mt19937 randomEng(0);
+		std::uniform_real_distribution<double> randomStart(-0.02, 0.02);
+		std::normal_distribution<double> randomStep(0.0, 5e-5);
+		std::normal_distribution<double> randomClimb(0.0, 0.5);
+
+		std::vector<std::vector<GpxPoint>> activities(nActivities);
+		for (auto &gpxData : activities)
+		{
+			double longitude = -1.5 + randomStart(randomEng), latitude = 53.8 + randomStart(randomEng), elevation_m = 100.0;
+			for (size_t i = 0; i < nPoints; ++i)
+			{
+				gpxData.emplace_back(longitude, latitude, elevation_m, 1000 * i);
+				longitude += randomStep(randomEng);
+				latitude += randomStep(randomEng);
+				elevation_m += randomClimb(randomEng);
+			}
+		}
+
+		return activities;
+	}
+
+	// The index compares positions at float precision
+	template <typename Fn>
+	std::vector<std::pair<uint32_t, uint32_t>> findPointsLinearly(const std::vector<std::vector<GpxPoint>> &activities, Fn isIncluded)
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> found;
+		for (uint32_t a = 0; a < activities.size(); ++a)
+		{
+			for (uint32_t i = 0; i < activities[a].size(); ++i)
+			{
+				const auto &p = activities[a][i];
+				if (isIncluded(static_cast<float>(p.longitude), static_cast<float>(p.latitude), static_cast<float>(p.elevation_m)))
+					found.emplace_back(a, i);
+			}
+		}
+
+		return found;
+	}
+
+	void assertRefsEqual(const std::vector<std::pair<uint32_t, uint32_t>> &expected, const std::vector<ActivityPointRef> &actual)
+	{
+		Assert::AreEqual(expected.size(), actual.size(), L"Different number of points found");
+		for (size_t i = 0; i < expected.size(); ++i)
+		{
+			Assert::AreEqual(expected[i].first, actual[i].activityId);
+			Assert::AreEqual(expected[i].second, actual[i].pointIndex);
+		}
+	}
+
+	void assertBoxQueriesMatchLinear(const ActivitySpatialIndex &index, const std::vector<std::vector<GpxPoint>> &activities)
+	{
+		std::mt19937 randomEng(1);
+		std::uniform_real_distribution<double> randomCentre(-0.03, 0.03);
+		std::uniform_real_distribution<double> randomSize(0.0, 0.01);
+
+		for (int q = 0; q < 50; ++q)
+		{
+			const auto minLongitude = -1.5 + randomCentre(randomEng), minLatitude = 53.8 + randomCentre(randomEng);
+			const auto maxLongitude = minLongitude + randomSize(randomEng), maxLatitude = minLatitude + randomSize(randomEng);
+			const auto minElevation_m = q % 2 ? 90.0 : -1e9, maxElevation_m = q % 2 ? 110.0 : 1e9;
+
+			const auto expected = findPointsLinearly(activities, [=](float longitude, float latitude, float elevation_m)
+			{
+				return longitude >= static_cast<float>(minLongitude) && longitude <= static_cast<float>(maxLongitude) &&
+					latitude >= static_cast<float>(minLatitude) && latitude <= static_cast<float>(maxLatitude) &&
+					elevation_m >= static_cast<float>(minElevation_m) && elevation_m <= static_cast<float>(maxElevation_m);
+			});
+
+			assertRefsEqual(expected, index.findPointsInBox(minLongitude, minLatitude, maxLongitude, maxLatitude, minElevation_m, maxElevation_m));
+
+			auto expectedActivityIds = std::vector<uint32_t>();
+			for (const auto &ref : expected)
+				expectedActivityIds.push_back(ref.first);
+			expectedActivityIds.erase(std::unique(expectedActivityIds.begin(), expectedActivityIds.end()), expectedActivityIds.end());
+
+			Assert::IsTrue(expectedActivityIds == index.findActivitiesInBox(minLongitude, minLatitude, maxLongitude, maxLatitude, minElevation_m, maxElevation_m),
+				L"Different activities found");
+		}
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(ActivitySpatialIndexTests)
+	{
+	public:
+
+		TEST_METHOD(BoxQueriesMatchLinearSearch)
+		{
+			const auto activities = createActivities(50, 2000);
+			const ActivitySpatialIndex index(activities);
+			Assert::AreEqual(size_t(50 * 2000), index.pointCount());
+
+			assertBoxQueriesMatchLinear(index, activities);
+		}
+
+		TEST_METHOD(RadiusQueriesMatchLinearSearch)
+		{
+			const auto activities = createActivities(50, 2000);
+			const ActivitySpatialIndex index(activities);
+
+			std::mt19937 randomEng(2);
+			std::uniform_real_distribution<double> randomCentre(-0.03, 0.03);
+			std::uniform_real_distribution<double> randomRadius_m(0.0, 500.0);
+			for (int q = 0; q < 50; ++q)
+			{
+				const auto longitude = -1.5 + randomCentre(randomEng), latitude = 53.8 + randomCentre(randomEng);
+				const auto radius_m = randomRadius_m(randomEng);
+
+				const auto latitude_rad = latitude * RADIANS_PER_DEGREE;
+				const auto expected = findPointsLinearly(activities, [=](float pointLongitude, float pointLatitude, float)
+				{
+					const auto pointLatitude_rad = pointLatitude * RADIANS_PER_DEGREE;
+					return equirectangularDistance_m(latitude_rad, longitude * RADIANS_PER_DEGREE, std::cos(latitude_rad),
+						pointLatitude_rad, pointLongitude * RADIANS_PER_DEGREE, std::cos(pointLatitude_rad)) <= radius_m;
+				});
+
+				assertRefsEqual(expected, index.findPointsNear(longitude, latitude, radius_m));
+			}
+
+			// Covering the pole includes every longitude
+			const ActivitySpatialIndex polarIndex({ { GpxPoint(0.0, 89.99, 0.0, 0), GpxPoint(180.0, 89.99, 0.0, 0), GpxPoint(180.0, 80.0, 0.0, 0) } });
+			Assert::AreEqual(size_t(2), polarIndex.findPointsNear(90.0, 89.99, 3000.0).size());
+		}
+
+		TEST_METHOD(RepeatedPositions)
+		{
+			// Many more points at one position than fit in an octree node
+			std::vector<std::vector<GpxPoint>> activities(3, std::vector<GpxPoint>(1000, GpxPoint(-1.5, 53.8, 100.0, 0)));
+			activities[1].emplace_back(-1.6, 53.9, 100.0, 0);
+
+			const ActivitySpatialIndex index(activities);
+			Assert::AreEqual(size_t(3000), index.findPointsNear(-1.5, 53.8, 1.0).size());
+			Assert::IsTrue(std::vector<uint32_t>{ 1 } == index.findActivitiesInBox(-1.7, 53.85, -1.55, 54.0), L"Unexpected activities found");
+
+			const ActivitySpatialIndex emptyIndex(std::vector<std::vector<GpxPoint>>{});
+			Assert::AreEqual(size_t(0), emptyIndex.findPointsInBox(-180.0, -90.0, 180.0, 90.0).size());
+		}
+
+		TEST_METHOD(SaveAndLoad)
+		{
+			const auto activities = createActivities(20, 1000);
+			const auto path = std::filesystem::temp_directory_path() / L"ActivitySpatialIndex.idx";
+			ActivitySpatialIndex(activities).save(path.wstring());
+
+			const ActivitySpatialIndex index(path.wstring());
+			Assert::AreEqual(size_t(20 * 1000), index.pointCount());
+			assertBoxQueriesMatchLinear(index, activities);
+			std::filesystem::remove(path);
+
+			Assert::ExpectException<std::runtime_error>([&path]() { ActivitySpatialIndex index(path.wstring()); });
+		}
+	};
+}
@@ -0,0 +1,305 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "ReindeerLib/DiffusionSimulator.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	// Positions after some updates from the same starting points
+	std::vector<XYZ<float>> simulate(uint32_t masterSeed, unsigned nThreads, const DiffusionSimulator::DataT &initialData, size_t nUpdates,
+		DiffusionRandomMode randomMode = DiffusionRandomMode::STD_NORMAL)
+	{
+		DiffusionSimulator simulator(masterSeed, nThreads, randomMode);
+		simulator.initialise(initialData);
+
+		for (size_t i = 0; i < nUpdates; ++i)
+		{
+			const auto timings = simulator.update();
+			Assert::IsFalse(timings.updatePositionThreadTimes.empty(), L"Expected a time for each thread");
+			if (nThreads != 0)
+				Assert::IsTrue(timings.updatePositionThreadTimes.size() <= nThreads, L"More thread times than threads");
+		}
+
+		std::vector<XYZ<float>> positions;
+		for (const auto &d : simulator.latest())
+			positions.insert(positions.end(), d.positions.begin(), d.positions.end());
+
+		return positions;
+	}
+
+	// Positions of the first frame from initialise(totalPoints, width, height), and after some updates
+	std::pair<std::vector<XYZ<float>>, std::vector<XYZ<float>>> simulateFromRandomStart(uint32_t masterSeed, unsigned nThreads, size_t nUpdates)
+	{
+		DiffusionSimulator simulator(masterSeed, nThreads);
+		simulator.initialise(1005, 100.f, 50.f);
+
+		std::vector<XYZ<float>> initialPositions;
+		for (const auto &d : simulator.latest())
+			initialPositions.insert(initialPositions.end(), d.positions.begin(), d.positions.end());
+
+		for (size_t i = 0; i < nUpdates; ++i)
+			simulator.update();
+
+		std::vector<XYZ<float>> positions;
+		for (const auto &d : simulator.latest())
+			positions.insert(positions.end(), d.positions.begin(), d.positions.end());
+
+		return std::make_pair(initialPositions, positions);
+	}
+
+	bool positionsEqual(const std::vector<XYZ<float>> &a, const std::vector<XYZ<float>> &b)
+	{
+		if (a.size() != b.size())
+			return false;
+
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z)
+				return false;
+		}
+
+		return true;
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(DiffusionSimulatorTests)
+	{
+	public:
+
+		TEST_METHOD(ChunksShareThePoints)
+		{
+			DiffusionSimulator simulator(0, 1);
+			simulator.initialise(1005, 100.f, 100.f);
+			size_t totalPoints = 0;
+			for (const auto &d : simulator.latest())
+			{
+				Assert::IsTrue(d.positions.size() <= 101, L"Points should be spread across the chunks");
+				Assert::AreEqual(3 * d.positions.size(), d.colours.size());
+				totalPoints += d.positions.size();
+			}
+			Assert::AreEqual(size_t(1005), totalPoints);
+		}
+
+		TEST_METHOD(ReproducibleForAnyThreadCount)
+		{
+			DiffusionSimulator simulator(0, 1);
+			simulator.initialise(10000, 100.f, 100.f);
+			const auto initialData = simulator.latest();
+
+			const auto expected = simulate(42, 1, initialData, 3);
+			for (const auto nThreads : { 2u, 3u, 10u, 0u })
+				Assert::IsTrue(positionsEqual(expected, simulate(42, nThreads, initialData, 3)), L"Positions depend on the number of threads");
+
+			Assert::IsFalse(positionsEqual(expected, simulate(43, 1, initialData, 3)), L"Positions should depend on the seed");
+		}
+
+		TEST_METHOD(RandomStartReproducibleForSeed)
+		{
+			const auto expected = simulateFromRandomStart(42, 1, 3);
+			for (const auto &p : expected.first)
+			{
+				Assert::IsTrue(p.x >= 0.f && p.x <= 100.f && p.y >= 0.f && p.y <= 50.f, L"Point outside width x height");
+				Assert::AreEqual(0.f, p.z);
+			}
+
+			for (const auto nThreads : { 1u, 3u, 0u })
+			{
+				const auto again = simulateFromRandomStart(42, nThreads, 3);
+				Assert::IsTrue(positionsEqual(expected.first, again.first), L"Starting positions differ for the same seed");
+				Assert::IsTrue(positionsEqual(expected.second, again.second), L"Positions differ for the same seed");
+			}
+
+			Assert::IsFalse(positionsEqual(expected.first, simulateFromRandomStart(43, 1, 0).first), L"Starting positions should depend on the seed");
+		}
+
+		TEST_METHOD(PhiloxReproducibleForAnyThreadCount)
+		{
+			DiffusionSimulator simulator(0, 1);
+			simulator.initialise(10000, 100.f, 100.f);
+			const auto initialData = simulator.latest();
+
+			const auto expected = simulate(42, 1, initialData, 3, DiffusionRandomMode::PHILOX);
+			for (const auto nThreads : { 2u, 3u, 10u, 0u })
+				Assert::IsTrue(positionsEqual(expected, simulate(42, nThreads, initialData, 3, DiffusionRandomMode::PHILOX)), L"Positions depend on the number of threads");
+
+			Assert::IsFalse(positionsEqual(expected, simulate(43, 1, initialData, 3, DiffusionRandomMode::PHILOX)), L"Positions should depend on the seed");
+			Assert::IsFalse(positionsEqual(expected, simulate(42, 1, initialData, 4, DiffusionRandomMode::PHILOX)), L"Each update should move the points");
+		}
+
+		TEST_METHOD(PhiloxMovementSpread)
+		{
+			const size_t nPoints = 100000;
+			DiffusionSimulator simulator(7, 0, DiffusionRandomMode::PHILOX);
+			simulator.initialise(nPoints, 100.f, 100.f);
+			const auto initialData = simulator.latest();
+			simulator.update();
+
+			// Movements should have a standard deviation of 2 on each axis
+			double sumSquares = 0.0;
+			const auto finalData = simulator.latest();
+			for (size_t c = 0; c < finalData.size(); ++c)
+			{
+				for (size_t i = 0; i < finalData[c].positions.size(); ++i)
+				{
+					const auto dx = double(finalData[c].positions[i].x) - initialData[c].positions[i].x;
+					const auto dz = double(finalData[c].positions[i].z) - initialData[c].positions[i].z;
+					sumSquares += dx * dx + dz * dz;
+				}
+			}
+			Assert::AreEqual(2.0, std::sqrt(sumSquares / (2 * nPoints)), 0.02);
+		}
+
+		TEST_METHOD(LayoutsGiveSamePoints)
+		{
+			for (const auto randomMode : { DiffusionRandomMode::STD_NORMAL, DiffusionRandomMode::PHILOX })
+			{
+				DiffusionSimulator soa(42, 0, randomMode, PointLayout::SOA);
+				soa.initialise(10007, 100.f, 100.f);
+
+				// Start the AOS simulator from the same points
+				for (const auto &d : soa.latest())
+				{
+					Assert::AreEqual(d.positions.size(), d.z.size());
+					Assert::AreEqual(size_t(0), reinterpret_cast<uintptr_t>(d.z.data()) % CACHE_LINE_SIZE, L"SOA arrays should be aligned");
+				}
+				DiffusionSimulator aos(42, 0, randomMode, PointLayout::AOS);
+				aos.initialise(soa.latest());
+
+				for (int i = 0; i < 3; ++i)
+				{
+					aos.update();
+					soa.update();
+				}
+
+				const auto &aosResult = aos.latest();
+				const auto &soaResult = soa.latest();
+				for (size_t c = 0; c < aosResult.size(); ++c)
+				{
+					Assert::IsTrue(positionsEqual(aosResult[c].positions, soaResult[c].positions), L"Interleaved SOA positions differ from AOS");
+					Assert::IsTrue(aosResult[c].colours == soaResult[c].colours, L"SOA colours differ from AOS");
+					for (size_t i = 0; i < soaResult[c].positions.size(); ++i)
+						Assert::AreEqual(soaResult[c].positions[i].y, soaResult[c].y[i], L"Positions should be interleaved from the SOA arrays");
+				}
+			}
+		}
+
+		TEST_METHOD(FusedKernelGivesSamePoints)
+		{
+			for (const auto randomMode : { DiffusionRandomMode::STD_NORMAL, DiffusionRandomMode::PHILOX })
+			{
+				for (const auto layout : { PointLayout::AOS, PointLayout::SOA })
+				{
+					DiffusionSimulator separate(42, 0, randomMode, layout, DiffusionKernel::SEPARATE);
+					separate.initialise(10007, 100.f, 100.f);
+					DiffusionSimulator fused(42, 0, randomMode, layout, DiffusionKernel::FUSED);
+					fused.initialise(separate.latest());
+
+					for (int i = 0; i < 3; ++i)
+					{
+						separate.update();
+						fused.update();
+					}
+
+					const auto &separateResult = separate.latest();
+					const auto &fusedResult = fused.latest();
+					for (size_t c = 0; c < separateResult.size(); ++c)
+					{
+						Assert::IsTrue(positionsEqual(separateResult[c].positions, fusedResult[c].positions), L"Fused positions differ");
+						Assert::IsTrue(separateResult[c].colours == fusedResult[c].colours, L"Fused colours differ");
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(KernelTimings)
+		{
+			DiffusionSimulator separate(1, 0, DiffusionRandomMode::STD_NORMAL, PointLayout::SOA, DiffusionKernel::SEPARATE);
+			separate.initialise(100000, 100.f, 100.f);
+			const auto separateTimings = separate.update();
+			Assert::IsTrue(separateTimings.copyTime.count() > 0);
+			Assert::IsTrue(separateTimings.updatePositionTime.count() > 0);
+			Assert::IsTrue(separateTimings.updateColourTime.count() > 0, L"Colour time should be reported");
+			Assert::IsTrue(separateTimings.interleaveTime.count() > 0);
+			Assert::AreEqual(int64_t(0), int64_t(separateTimings.fusedUpdateTime.count()));
+
+			DiffusionSimulator fused(1, 0, DiffusionRandomMode::STD_NORMAL, PointLayout::SOA, DiffusionKernel::FUSED);
+			fused.initialise(100000, 100.f, 100.f);
+			const auto fusedTimings = fused.update();
+			Assert::IsTrue(fusedTimings.fusedUpdateTime.count() > 0);
+			Assert::AreEqual(int64_t(0), int64_t(fusedTimings.copyTime.count() + fusedTimings.updatePositionTime.count() +
+				fusedTimings.updateColourTime.count() + fusedTimings.interleaveTime.count()));
+			Assert::IsFalse(fusedTimings.updatePositionThreadTimes.empty());
+		}
+
+		TEST_METHOD(LatestUnchangedUntilNextCall)
+		{
+			DiffusionSimulator simulator(3, 0);
+			simulator.initialise(1000, 100.f, 100.f);
+
+			const auto &frame = simulator.latest();
+			std::vector<XYZ<float>> framePositions;
+			for (const auto &d : frame)
+				framePositions.insert(framePositions.end(), d.positions.begin(), d.positions.end());
+
+			// Updates go into the other buffers
+			for (int i = 0; i < 3; ++i)
+				simulator.update();
+
+			std::vector<XYZ<float>> positionsAfterUpdates;
+			for (const auto &d : frame)
+				positionsAfterUpdates.insert(positionsAfterUpdates.end(), d.positions.begin(), d.positions.end());
+			Assert::IsTrue(positionsEqual(framePositions, positionsAfterUpdates), L"The reader's frame changed");
+
+			std::vector<XYZ<float>> latestPositions;
+			for (const auto &d : simulator.latest())
+				latestPositions.insert(latestPositions.end(), d.positions.begin(), d.positions.end());
+			Assert::IsFalse(positionsEqual(framePositions, latestPositions), L"The latest frame should have moved");
+		}
+
+		TEST_METHOD(UpdateBenchmark)
+		{
+			// Whole update() times, averaged over a few updates
+			const auto time_ms = [](unsigned nThreads, DiffusionRandomMode randomMode, PointLayout layout, DiffusionKernel kernel)
+			{
+				DiffusionSimulator simulator(1, nThreads, randomMode, layout, kernel);
+				simulator.initialise(2000000, 100.f, 100.f);
+
+				std::chrono::nanoseconds total = {};
+				for (int i = 0; i < 5; ++i)
+				{
+					const auto timings = simulator.update();
+					total += timings.copyTime + timings.updatePositionTime + timings.updateColourTime + timings.interleaveTime + timings.fusedUpdateTime;
+				}
+
+				return std::chrono::duration<double, std::milli>(total).count() / 5;
+			};
+
+			// Every sweep is threaded in both kernels, so they compare fairly on all threads too
+			for (const auto nThreads : { 1u, 0u })
+			{
+				for (const auto randomMode : { DiffusionRandomMode::STD_NORMAL, DiffusionRandomMode::PHILOX })
+				{
+					char message[192];
+					std::snprintf(message, sizeof(message), "2000000 points on %s, %s: AOS %.1f ms (fused %.1f ms), SOA %.1f ms (fused %.1f ms) per update",
+						nThreads == 1 ? "one thread" : "all threads", randomMode == DiffusionRandomMode::PHILOX ? "PHILOX" : "STD_NORMAL",
+						time_ms(nThreads, randomMode, PointLayout::AOS, DiffusionKernel::SEPARATE), time_ms(nThreads, randomMode, PointLayout::AOS, DiffusionKernel::FUSED),
+						time_ms(nThreads, randomMode, PointLayout::SOA, DiffusionKernel::SEPARATE), time_ms(nThreads, randomMode, PointLayout::SOA, DiffusionKernel::FUSED));
+					Logger::WriteMessage(message);
+				}
+			}
+		}
+	};
+}
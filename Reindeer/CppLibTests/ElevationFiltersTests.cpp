@@ -0,0 +1,152 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "ReindeerLib/ElevationFilters.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	// A steady climb with GPS noise
+	std::vector<double> createNoisyClimb(size_t nSamples, double climbPerSample_m, double noise_m)
+	{
+		std::mt19937 randomEng(0);
+		std::normal_distribution<double> randomNoise_m(0.0, noise_m);
+
+		std::vector<double> elevation_m(nSamples);
+		for (size_t i = 0; i < nSamples; ++i)
+			elevation_m[i] = 100.0 + climbPerSample_m * static_cast<double>(i) + randomNoise_m(randomEng);
+
+		return elevation_m;
+	}
+
+	double totalClimb_m(const std::vector<double> &elevation_m)
+	{
+		double climb_m = 0.0;
+		for (size_t i = 1; i < elevation_m.size(); ++i)
+			climb_m += std::max(0.0, elevation_m[i] - elevation_m[i - 1]);
+
+		return climb_m;
+	}
+
+	// Direct weighted mean of the samples that exist
+	std::vector<double> convolveNaive(const std::vector<double> &values, const std::vector<double> &kernel)
+	{
+		const auto halfWidth = static_cast<std::ptrdiff_t>(kernel.size() / 2);
+		const auto n = static_cast<std::ptrdiff_t>(values.size());
+
+		std::vector<double> result(values.size());
+		for (std::ptrdiff_t i = 0; i < n; ++i)
+		{
+			double sum = 0.0, weight = 0.0;
+			for (std::ptrdiff_t j = -halfWidth; j <= halfWidth; ++j)
+			{
+				if (i + j >= 0 && i + j < n)
+				{
+					sum += kernel[j + halfWidth] * values[i + j];
+					weight += kernel[j + halfWidth];
+				}
+			}
+			result[i] = sum / weight;
+		}
+
+		return result;
+	}
+
+	void assertNearlyEqual(const std::vector<double> &expected, const std::vector<double> &actual)
+	{
+		Assert::AreEqual(expected.size(), actual.size());
+		for (size_t i = 0; i < expected.size(); ++i)
+			Assert::AreEqual(expected[i], actual[i], 1e-9);
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(ElevationFiltersTests)
+	{
+	public:
+
+		TEST_METHOD(MovingAverage)
+		{
+			std::vector<double> elevation_m = { 0.0, 3.0, 6.0, 9.0, 12.0 };
+			smoothElevationMovingAverage(elevation_m.data(), elevation_m.size(), 1);
+			assertNearlyEqual({ 1.5, 3.0, 6.0, 9.0, 10.5 }, elevation_m);
+
+			// Across block boundaries, and wider than the data
+			for (const auto nSamples : { size_t(1), size_t(7), size_t(1023), size_t(1024), size_t(3000) })
+			{
+				for (const auto halfWidth : { size_t(0), size_t(2), size_t(10), size_t(1500) })
+				{
+					auto smoothed_m = createNoisyClimb(nSamples, 0.1, 1.0);
+					const auto expected_m = convolveNaive(smoothed_m, std::vector<double>(2 * halfWidth + 1, 1.0));
+					smoothElevationMovingAverage(smoothed_m.data(), smoothed_m.size(), halfWidth);
+					assertNearlyEqual(expected_m, smoothed_m);
+				}
+			}
+		}
+
+		TEST_METHOD(Gaussian)
+		{
+			// Constant stays constant, including at the ends
+			std::vector<double> flat_m(100, 42.0);
+			smoothElevationGaussian(flat_m.data(), flat_m.size(), 4.0);
+			assertNearlyEqual(std::vector<double>(100, 42.0), flat_m);
+
+			// The weights are symmetric, so a straight line stays straight away from the ends
+			std::vector<double> line_m(100);
+			for (size_t i = 0; i < line_m.size(); ++i)
+				line_m[i] = 0.5 * static_cast<double>(i);
+			auto smoothedLine_m = line_m;
+			smoothElevationGaussian(smoothedLine_m.data(), smoothedLine_m.size(), 2.0);
+			for (size_t i = 6; i < 94; ++i)
+				Assert::AreEqual(line_m[i], smoothedLine_m[i], 1e-9);
+
+			const auto noisy_m = createNoisyClimb(5000, 0.05, 2.0);
+			auto smoothed_m = noisy_m;
+			smoothElevationGaussian(smoothed_m.data(), smoothed_m.size(), 5.0);
+			Assert::IsTrue(totalClimb_m(smoothed_m) < 0.5 * totalClimb_m(noisy_m), L"Smoothing should remove most of the noise's climb");
+
+			Assert::ExpectException<std::invalid_argument>([&smoothed_m]() { smoothElevationGaussian(smoothed_m.data(), smoothed_m.size(), 0.0); });
+		}
+
+		TEST_METHOD(Hysteresis)
+		{
+			// Noise within the threshold is ignored, then the climb is followed threshold_m behind
+			std::vector<double> elevation_m = { 10.0, 11.0, 9.0, 10.5, 13.0, 15.0, 14.0, 12.0, 8.0 };
+			smoothElevationHysteresis(elevation_m.data(), elevation_m.size(), 2.0);
+			assertNearlyEqual({ 10.0, 10.0, 10.0, 10.0, 11.0, 13.0, 13.0, 13.0, 10.0 }, elevation_m);
+
+			// A 100m climb loses only the threshold
+			const auto noisy_m = createNoisyClimb(10000, 0.01, 0.5);
+			auto smoothed_m = noisy_m;
+			smoothElevationHysteresis(smoothed_m.data(), smoothed_m.size(), 3.0);
+			Assert::AreEqual(100.0, totalClimb_m(smoothed_m), 5.0);
+
+			Assert::ExpectException<std::invalid_argument>([&smoothed_m]() { smoothElevationHysteresis(smoothed_m.data(), smoothed_m.size(), -1.0); });
+		}
+
+		TEST_METHOD(SmoothGpxElevations)
+		{
+			std::vector<GpxPoint> gpxData;
+			for (const auto elevation_m : { 0.0, 3.0, 6.0, 9.0, 12.0 })
+				gpxData.emplace_back(1.0, 2.0, elevation_m, 3);
+
+			smoothElevationMovingAverage(gpxData, 1);
+			Assert::AreEqual(1.5, gpxData[0].elevation_m, 1e-9);
+			Assert::AreEqual(6.0, gpxData[2].elevation_m, 1e-9);
+			Assert::AreEqual(1.0, gpxData[0].longitude);
+
+			smoothElevationHysteresis(gpxData, 10.0);
+			Assert::AreEqual(1.5, gpxData[4].elevation_m, 1e-9);
+		}
+	};
+}
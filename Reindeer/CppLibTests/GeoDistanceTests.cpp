@@ -0,0 +1,121 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <random>
+#include <vector>
+
+#include "ReindeerLib/GeoDistance.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	double haversineDistance_m(const GpxPoint &from, const GpxPoint &to)
+	{
+		const auto fromLatitude_rad = from.latitude * RADIANS_PER_DEGREE;
+		const auto toLatitude_rad = to.latitude * RADIANS_PER_DEGREE;
+		const auto sinHalfLatDiff = std::sin(0.5 * (toLatitude_rad - fromLatitude_rad));
+		const auto sinHalfLongDiff = std::sin(0.5 * (to.longitude - from.longitude) * RADIANS_PER_DEGREE);
+		const auto a = sinHalfLatDiff * sinHalfLatDiff +
+			std::cos(fromLatitude_rad) * std::cos(toLatitude_rad) * sinHalfLongDiff * sinHalfLongDiff;
+		return 2.0 * EARTH_RADIUS_m * std::asin(std::sqrt(a));
+	}
+
+	// Random walk with steps of up to roughly 100m
+	std::vector<GpxPoint> createRandomWalk(unsigned seed, size_t nPoints)
+	{
+		std::mt19937 randomEng(seed);
+		std::uniform_real_distribution<double> randomStep_deg(-0.001, 0.001);
+		std::uniform_real_distribution<double> randomStart_deg(-70.0, 70.0);
+
+		std::vector<GpxPoint> track;
+		double longitude = randomStart_deg(randomEng);
+		double latitude = randomStart_deg(randomEng);
+		for (size_t i = 0; i < nPoints; ++i)
+		{
+			track.push_back(GpxPoint(longitude, latitude, 0.0, i));
+			longitude += randomStep_deg(randomEng);
+			latitude += randomStep_deg(randomEng);
+		}
+
+		return track;
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(GeoDistanceTests)
+	{
+	public:
+
+		TEST_METHOD(StepDistancesMatchHaversine)
+		{
+			// One degree of latitude
+			const auto oneDegree = DistTimeElev::fromGpx(GpxPoint(0.0, 10.0, 0.0, 0), GpxPoint(0.0, 11.0, 0.0, 1));
+			Assert::AreEqual(EARTH_RADIUS_m * RADIANS_PER_DEGREE, oneDegree.distanceTime.distance_m, 1e-6);
+
+			// A kilometre or so at a high latitude
+			const GpxPoint from(-1.5, 60.0, 0.0, 0);
+			const GpxPoint to(-1.49, 60.005, 0.0, 1);
+			const auto expected_m = haversineDistance_m(from, to);
+			Assert::AreEqual(expected_m, DistTimeElev::fromGpx(from, to).distanceTime.distance_m, 1e-7 * expected_m);
+
+			const auto track = createRandomWalk(0, 1000);
+			const auto stepDistances_m = calculateStepDistances(track);
+			for (size_t i = 1; i < track.size(); ++i)
+			{
+				const auto expectedStep_m = haversineDistance_m(track[i - 1], track[i]);
+				Assert::AreEqual(expectedStep_m, stepDistances_m[i], 1e-7 * expectedStep_m);
+			}
+		}
+
+		TEST_METHOD(StepDistancesSameForEachSimdLevel)
+		{
+			const auto supportedLevel = detectSimdLevel();
+			for (const auto nPoints : { 0, 1, 2, 3, 5, 255, 256, 257, 511, 1000 })
+			{
+				const auto track = createRandomWalk(nPoints, nPoints);
+				for (const auto simdLevel : { SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2 })
+				{
+					if (simdLevel > supportedLevel)
+						continue;
+
+					std::vector<double> stepDistances_m(track.size(), -1.0);
+					calculateStepDistances(track.data(), track.size(), stepDistances_m.data(), simdLevel);
+					for (size_t i = 0; i < track.size(); ++i)
+					{
+						const auto expected_m = i == 0 ? 0.0 : DistTimeElev::fromGpx(track[i - 1], track[i]).distanceTime.distance_m;
+						Assert::AreEqual(expected_m, stepDistances_m[i], L"Step distance differs from DistTimeElev::fromGpx");
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(StepDistancesAcrossAntimeridian)
+		{
+			// Zigzags back and forth across 180 degrees, about 22m each step at the equator
+			std::vector<GpxPoint> track;
+			for (int i = 0; i < 11; ++i)
+				track.push_back(GpxPoint(i % 2 == 0 ? 179.9999 : -179.9999, 0.001 * i, 0.0, i));
+
+			const auto supportedLevel = detectSimdLevel();
+			for (const auto simdLevel : { SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2 })
+			{
+				if (simdLevel > supportedLevel)
+					continue;
+
+				std::vector<double> stepDistances_m(track.size(), -1.0);
+				calculateStepDistances(track.data(), track.size(), stepDistances_m.data(), simdLevel);
+				for (size_t i = 1; i < track.size(); ++i)
+				{
+					const auto expected_m = haversineDistance_m(track[i - 1], track[i]);
+					Assert::IsTrue(expected_m < 200.0, L"Expected a short step");
+					Assert::AreEqual(expected_m, stepDistances_m[i], 1e-6 * expected_m);
+					Assert::AreEqual(DistTimeElev::fromGpx(track[i - 1], track[i]).distanceTime.distance_m, stepDistances_m[i], L"Step distance differs from DistTimeElev::fromGpx");
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "ReindeerLib/GpxParser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	const char *const exampleGpx = R"(<?xml version="1.0" encoding="UTF-8"?>
+<gpx version="1.1" creator="test" xmlns="http://www.topografix.com/GPX/1/1">
+  <metadata><time>2019-01-01T00:00:00Z</time></metadata>
+  <trk>
+    <name>Morning Run</name>
+    <trkseg>
+      <trkpt lat="51.4785320" lon="-0.0106180">
+        <ele>12.4</ele>
+        <time>2019-06-01T07:30:00Z</time>
+        <extensions><gpxtpx:TrackPointExtension><gpxtpx:hr>140</gpxtpx:hr></gpxtpx:TrackPointExtension></extensions>
+      </trkpt>
+      <trkpt lon='-0.0105' lat='51.4786'>
+        <time>2019-06-01T08:30:01.250+01:00</time>
+        <ele> -3 </ele>
+      </trkpt>
+      <trkpt lat="51.4787" lon="-0.0104"/>
+    </trkseg>
+  </trk>
+</gpx>)";
+
+	std::vector<GpxPoint> parseString(const std::string &gpx)
+	{
+		return parseGpx(gpx.data(), gpx.size());
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(GpxParserTests)
+	{
+	public:
+
+		TEST_METHOD(ParseTrackPoints)
+		{
+			const auto points = parseString(exampleGpx);
+			Assert::AreEqual(size_t(3), points.size(), L"Unexpected number of points");
+
+			Assert::AreEqual(51.4785320, points[0].latitude);
+			Assert::AreEqual(-0.0106180, points[0].longitude);
+			Assert::AreEqual(12.4, points[0].elevation_m);
+			Assert::AreEqual(uint64_t(1559374200000), points[0].dateTime_ms);
+
+			// Attributes in either order, with an offset and fractional seconds
+			Assert::AreEqual(51.4786, points[1].latitude);
+			Assert::AreEqual(-0.0105, points[1].longitude);
+			Assert::AreEqual(-3.0, points[1].elevation_m);
+			Assert::AreEqual(uint64_t(1559374201250), points[1].dateTime_ms);
+
+			// No children
+			Assert::AreEqual(51.4787, points[2].latitude);
+			Assert::AreEqual(0.0, points[2].elevation_m);
+			Assert::AreEqual(uint64_t(0), points[2].dateTime_ms);
+
+			Assert::AreEqual(size_t(0), parseString("").size());
+			Assert::AreEqual(size_t(0), parseString("<gpx></gpx>").size());
+		}
+
+		TEST_METHOD(ParseNumbersMatchStrtod)
+		{
+			std::mt19937 randomEng(0);
+			std::uniform_real_distribution<double> randomCoordinate(-180.0, 180.0);
+			for (int i = 0; i < 10000; ++i)
+			{
+				char text[64];
+				std::snprintf(text, sizeof(text), "%.*f", 1 + i % 12, randomCoordinate(randomEng));
+				if (i % 100 == 0)
+					std::snprintf(text, sizeof(text), "%.17e", randomCoordinate(randomEng));
+
+				const auto points = parseString(std::string("<trkpt lat=\"") + text + "\" lon=\"0\"/>");
+				Assert::AreEqual(std::strtod(text, nullptr), points.front().latitude, L"Differs from strtod");
+			}
+		}
+
+		TEST_METHOD(InvalidGpxThrows)
+		{
+			Assert::ExpectException<std::runtime_error>([]() { parseString("<trkpt lat=\"1\"></trkpt>"); });
+			Assert::ExpectException<std::runtime_error>([]() { parseString("<trkpt lat=\"x\" lon=\"1\"></trkpt>"); });
+			Assert::ExpectException<std::runtime_error>([]() { parseString("<trkpt lat=\"1\" lon=\"1\"><time>yesterday</time></trkpt>"); });
+			Assert::ExpectException<std::runtime_error>([]() { parseString("<trkpt lat=\"1\" lon=\"1\"><ele>1"); });
+		}
+
+		TEST_METHOD(ReadGpxFile)
+		{
+			const auto path = std::filesystem::temp_directory_path() / L"ReadGpxFile.gpx";
+			{
+				std::ofstream file(path, std::ios::binary);
+				file << exampleGpx;
+			}
+
+			Assert::AreEqual(size_t(3), readGpxFile(path.wstring()).size(), L"Unexpected number of points");
+			std::filesystem::remove(path);
+		}
+	};
+}
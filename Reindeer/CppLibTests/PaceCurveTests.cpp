@@ -0,0 +1,540 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "ReindeerLib/PaceCurve.h"
+#include "ReindeerLib/PaceCurveCache.h"
+
+#include "TestTracks.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	void assertPaceCurvesEqual(const std::vector<PaceCurvePoint> &expected, const std::vector<PaceCurvePoint> &actual)
+	{
+		Assert::AreEqual(expected.size(), actual.size(), L"Pace curve sizes differ");
+		for (size_t i = 0; i < expected.size(); ++i)
+		{
+			const auto &e = expected[i];
+			const auto &a = actual[i];
+			Assert::AreEqual(e.distance_m, a.distance_m, L"Distance differs");
+			Assert::AreEqual(e.bestPaceSegment.distanceTime.distance_m, a.bestPaceSegment.distanceTime.distance_m, L"Segment distance differs");
+			Assert::AreEqual(e.bestPaceSegment.distanceTime.time_s, a.bestPaceSegment.distanceTime.time_s, L"Segment time differs");
+			Assert::AreEqual(e.bestPaceSegment.elevation.elevationDiff_m, a.bestPaceSegment.elevation.elevationDiff_m, L"Segment elevation diff differs");
+			Assert::AreEqual(e.bestPaceSegment.elevation.cumulativeElevation_m, a.bestPaceSegment.elevation.cumulativeElevation_m, L"Segment cumulative elevation differs");
+		}
+	}
+
+	// For curves where the segment sums may have been rounded differently
+	void assertPaceCurvesNearlyEqual(const std::vector<PaceCurvePoint> &expected, const std::vector<PaceCurvePoint> &actual)
+	{
+		constexpr double tolerance = 1e-6;
+		Assert::AreEqual(expected.size(), actual.size(), L"Pace curve sizes differ");
+		for (size_t i = 0; i < expected.size(); ++i)
+		{
+			const auto &e = expected[i];
+			const auto &a = actual[i];
+			Assert::AreEqual(e.distance_m, a.distance_m, L"Distance differs");
+			Assert::AreEqual(e.bestPaceSegment.distanceTime.distance_m, a.bestPaceSegment.distanceTime.distance_m, tolerance, L"Segment distance differs");
+			Assert::AreEqual(e.bestPaceSegment.distanceTime.time_s, a.bestPaceSegment.distanceTime.time_s, tolerance, L"Segment time differs");
+			Assert::AreEqual(e.bestPaceSegment.elevation.elevationDiff_m, a.bestPaceSegment.elevation.elevationDiff_m, tolerance, L"Segment elevation diff differs");
+			Assert::AreEqual(e.bestPaceSegment.elevation.cumulativeElevation_m, a.bestPaceSegment.elevation.cumulativeElevation_m, tolerance, L"Segment cumulative elevation differs");
+		}
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(PaceCurveTests)
+	{
+	public:
+
+		TEST_METHOD(PaceCurveSimpleTrack)
+		{
+			// 10m in 1s, then 30m in 1s, then 10m in 1s
+			const std::vector<GpxPoint> track = {
+				GpxPoint(0.0, 0.0, 0.0, 0),
+				GpxPoint(10.0 * DEGREES_PER_METRE, 0.0, 0.0, 1000),
+				GpxPoint(40.0 * DEGREES_PER_METRE, 0.0, 0.0, 2000),
+				GpxPoint(50.0 * DEGREES_PER_METRE, 0.0, 0.0, 3000) };
+
+			const auto curve = calculatePaceCurve(track, 9.5, 10.0, -1000.0);
+
+			Assert::AreEqual(size_t(5), curve.size(), L"Unexpected number of points");
+			// 10m-30m are covered by the fast middle segment
+			Assert::AreEqual(30.0, curve[0].bestPaceSegment.distanceTime.distance_m, 1e-6);
+			Assert::AreEqual(30.0, curve[2].bestPaceSegment.distanceTime.distance_m, 1e-6);
+			// 40m must include one of the slow segments
+			Assert::AreEqual(40.0, curve[3].bestPaceSegment.distanceTime.distance_m, 1e-6);
+			Assert::AreEqual(50.0, curve[4].bestPaceSegment.distanceTime.distance_m, 1e-6);
+		}
+
+		TEST_METHOD(PaceCurveEnginesMatch)
+		{
+			for (unsigned seed = 0; seed < 20; ++seed)
+			{
+				const auto track = createRandomTrack(seed, 50 + 10 * seed);
+				for (const auto minElevationDiff_m : { -1000.0, 0.0, 5.0 })
+				{
+					const auto exhaustive = calculatePaceCurve(track, 5.0, 7.0, minElevationDiff_m, PaceCurveEngine::EXHAUSTIVE);
+					const auto prefixSum = calculatePaceCurve(track, 5.0, 7.0, minElevationDiff_m, PaceCurveEngine::PREFIX_SUM);
+					assertPaceCurvesNearlyEqual(exhaustive, prefixSum);
+				}
+			}
+		}
+
+		TEST_METHOD(PaceCurveBuilderMatchesBatch)
+		{
+			for (unsigned seed = 0; seed < 10; ++seed)
+			{
+				const auto track = createRandomTrack(seed, 100);
+				for (const auto minElevationDiff_m : { -1000.0, 0.0, 5.0 })
+				{
+					PaceCurveBuilder builder(5.0, 7.0, minElevationDiff_m);
+					std::vector<GpxPoint> pointsSoFar;
+					for (const auto &p : track)
+					{
+						builder.append(p);
+						pointsSoFar.push_back(p);
+
+						if (pointsSoFar.size() % 10 == 0)
+						{
+							const auto batch = calculatePaceCurve(pointsSoFar, 5.0, 7.0, minElevationDiff_m, PaceCurveEngine::EXHAUSTIVE);
+							assertPaceCurvesNearlyEqual(batch, builder.current());
+						}
+					}
+
+					Assert::AreEqual(track.size(), builder.pointCount(), L"Unexpected point count");
+				}
+			}
+		}
+
+		TEST_METHOD(PaceCurveThreadCountDoesNotChangeOutput)
+		{
+			for (unsigned seed = 0; seed < 5; ++seed)
+			{
+				const auto track = createRandomTrack(seed, 300);
+				for (const auto engine : { PaceCurveEngine::EXHAUSTIVE, PaceCurveEngine::PREFIX_SUM })
+				{
+					for (const auto minElevationDiff_m : { -1000.0, 5.0 })
+					{
+						const auto singleThreaded = calculatePaceCurve(track, 5.0, 7.0, minElevationDiff_m, engine, 1);
+						const auto multiThreaded = calculatePaceCurve(track, 5.0, 7.0, minElevationDiff_m, engine, 4);
+						assertPaceCurvesEqual(singleThreaded, multiThreaded);
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(ActivityColumnsSegmentSums)
+		{
+			const auto track = createRandomTrack(1, 200);
+			const auto activity = ActivityColumns::fromGpx(track);
+			Assert::AreEqual(track.size(), activity.size(), L"Unexpected column size");
+			Assert::IsTrue(reinterpret_cast<uintptr_t>(activity.distance_m.data()) % CACHE_LINE_SIZE == 0, L"Column isn't aligned");
+
+			for (const auto range : { std::make_pair(0, 199), std::make_pair(10, 11), std::make_pair(50, 120) })
+			{
+				auto summed = DistTimeElev::zero();
+				for (auto i = range.first + 1; i <= range.second; ++i)
+					summed = DistTimeElev::sum(summed, DistTimeElev::fromGpx(track[i - 1], track[i]));
+
+				const auto segment = activity.segment(range.first, range.second);
+				Assert::AreEqual(summed.distanceTime.distance_m, segment.distanceTime.distance_m, 1e-6, L"Distance differs");
+				Assert::AreEqual(summed.distanceTime.time_s, segment.distanceTime.time_s, 1e-9, L"Time differs");
+				Assert::AreEqual(summed.elevation.elevationDiff_m, segment.elevation.elevationDiff_m, L"Elevation diff differs");
+				Assert::AreEqual(summed.elevation.cumulativeElevation_m, segment.elevation.cumulativeElevation_m, L"Cumulative elevation differs");
+			}
+
+			const auto fromColumns = calculatePaceCurve(activity, 5.0, 7.0, -1000.0);
+			const auto fromGpx = calculatePaceCurve(track, 5.0, 7.0, -1000.0, PaceCurveEngine::EXHAUSTIVE);
+			assertPaceCurvesNearlyEqual(fromGpx, fromColumns);
+		}
+
+		TEST_METHOD(MergePaceCurvesParallelMatchesMerge)
+		{
+			std::vector<std::vector<GpxPoint>> activities;
+			std::vector<std::vector<PaceCurvePoint>> paceCurves;
+			for (unsigned seed = 0; seed < 25; ++seed)
+			{
+				activities.push_back(createRandomTrack(seed, 40 + 5 * seed));
+				paceCurves.push_back(calculatePaceCurve(activities.back(), 5.0, 7.0, -1000.0, PaceCurveEngine::PREFIX_SUM));
+			}
+
+			assertPaceCurvesEqual(mergePaceCurves(paceCurves), mergePaceCurvesParallel(paceCurves, 4));
+			assertPaceCurvesEqual(mergePaceCurves(paceCurves), calculateMergedPaceCurve(activities, 5.0, 7.0, -1000.0, 4));
+
+			// Curves don't have to be sorted or have unique distances
+			auto unsortedCurves = paceCurves;
+			std::mt19937 randomEng(0);
+			for (auto &curve : unsortedCurves)
+			{
+				const auto copy = curve;
+				curve.insert(curve.end(), copy.begin(), copy.end());
+				std::shuffle(curve.begin(), curve.end(), randomEng);
+			}
+
+			assertPaceCurvesEqual(mergePaceCurves(unsortedCurves), mergePaceCurvesParallel(unsortedCurves, 4));
+		}
+
+		TEST_METHOD(PaceCurveCacheRoundTrip)
+		{
+			const auto path = (std::filesystem::temp_directory_path() / L"PaceCurveCacheRoundTrip.cache").wstring();
+			std::filesystem::remove(path);
+
+			const auto trackA = createRandomTrack(1, 100);
+			const auto trackB = createRandomTrack(2, 100);
+			const auto expectedA = calculatePaceCurve(trackA, 5.0, 7.0, -1000.0, PaceCurveEngine::PREFIX_SUM);
+			const auto expectedB = calculatePaceCurve(trackB, 5.0, 7.0, -1000.0, PaceCurveEngine::PREFIX_SUM);
+
+			{
+				PaceCurveCache cache(path, 1 << 20);
+				assertPaceCurvesEqual(expectedA, cache.calculatePaceCurve(trackA, 5.0, 7.0, -1000.0));
+				assertPaceCurvesEqual(expectedA, cache.calculatePaceCurve(trackA, 5.0, 7.0, -1000.0));
+				cache.calculatePaceCurve(trackA, 5.0, 10.0, -1000.0);
+				Assert::AreEqual(size_t(1), cache.hitCount());
+				Assert::AreEqual(size_t(2), cache.entryCount());
+			}
+
+			{
+				PaceCurveCache cache(path, 1 << 20);
+				Assert::AreEqual(size_t(2), cache.entryCount());
+				assertPaceCurvesEqual(expectedA, cache.calculatePaceCurve(trackA, 5.0, 7.0, -1000.0));
+				Assert::AreEqual(size_t(1), cache.hitCount());
+
+				// Hits alone don't rewrite the file
+				const auto writeTime = std::filesystem::last_write_time(path);
+				std::filesystem::last_write_time(path, writeTime - std::chrono::hours(1));
+				cache.flush();
+				Assert::IsTrue(writeTime - std::chrono::hours(1) == std::filesystem::last_write_time(path), L"Cache file was rewritten");
+			}
+
+			{
+				// No room for a third entry, so the least recently used one is evicted
+				PaceCurveCache cache(path, static_cast<size_t>(std::filesystem::file_size(path)));
+				assertPaceCurvesEqual(expectedB, cache.calculatePaceCurve(trackB, 5.0, 7.0, -1000.0));
+				cache.flush();
+				Assert::IsTrue(cache.entryCount() < 3);
+				assertPaceCurvesEqual(expectedB, cache.calculatePaceCurve(trackB, 5.0, 7.0, -1000.0));
+				Assert::AreEqual(size_t(1), cache.hitCount());
+			}
+
+			std::filesystem::remove(path);
+		}
+
+		TEST_METHOD(PaceCurveCacheKeepsEntriesWhenFlushFails)
+		{
+			// A directory can't be replaced by the cache file
+			const auto path = std::filesystem::temp_directory_path() / L"PaceCurveCacheKeepsEntriesWhenFlushFails.cache";
+			std::filesystem::remove_all(path);
+			std::filesystem::create_directories(path / L"blocker");
+
+			const auto track = createRandomTrack(1, 100);
+			const auto expected = calculatePaceCurve(track, 5.0, 7.0, -1000.0, PaceCurveEngine::PREFIX_SUM);
+			{
+				PaceCurveCache cache(path.wstring(), 1 << 20);
+				cache.calculatePaceCurve(track, 5.0, 7.0, -1000.0);
+				Assert::ExpectException<std::runtime_error>([&cache]() { cache.flush(); });
+
+				Assert::AreEqual(size_t(1), cache.entryCount());
+				assertPaceCurvesEqual(expected, cache.calculatePaceCurve(track, 5.0, 7.0, -1000.0));
+				Assert::AreEqual(size_t(1), cache.hitCount());
+
+				// Still waiting to be written
+				Assert::ExpectException<std::runtime_error>([&cache]() { cache.flush(); });
+				Assert::IsFalse(std::filesystem::exists(path.wstring() + L".tmp"), L"Temporary file left behind");
+			}
+
+			std::filesystem::remove_all(path);
+		}
+
+		TEST_METHOD(PaceCurveCacheKeepsEntriesWhenTempFileFails)
+		{
+			// A directory where the temporary file goes can't be opened for writing
+			const auto path = std::filesystem::temp_directory_path() / L"PaceCurveCacheKeepsEntriesWhenTempFileFails.cache";
+			const auto tempPath = std::filesystem::path(path.wstring() + L".tmp");
+			std::filesystem::remove_all(path);
+			std::filesystem::remove_all(tempPath);
+			std::filesystem::create_directory(tempPath);
+
+			const auto track = createRandomTrack(1, 100);
+			const auto expected = calculatePaceCurve(track, 5.0, 7.0, -1000.0, PaceCurveEngine::PREFIX_SUM);
+			{
+				PaceCurveCache cache(path.wstring(), 1 << 20);
+				cache.calculatePaceCurve(track, 5.0, 7.0, -1000.0);
+				Assert::ExpectException<std::runtime_error>([&cache]() { cache.flush(); });
+
+				Assert::IsFalse(std::filesystem::exists(tempPath), L"Temporary file left behind");
+				Assert::IsFalse(std::filesystem::exists(path), L"Cache file shouldn't have been written");
+				Assert::AreEqual(size_t(1), cache.entryCount());
+
+				// Nothing in the way now
+				cache.flush();
+			}
+
+			{
+				PaceCurveCache cache(path.wstring(), 1 << 20);
+				assertPaceCurvesEqual(expected, cache.calculatePaceCurve(track, 5.0, 7.0, -1000.0));
+				Assert::AreEqual(size_t(1), cache.hitCount());
+			}
+
+			std::filesystem::remove_all(path);
+			std::filesystem::remove_all(tempPath);
+		}
+
+		TEST_METHOD(PaceCurvesPerElevationThresholdMatchSingleCurves)
+		{
+			const std::vector<double> minElevationDiffs_m = { -1000.0, -5.0, 0.0, 3.0, 5.0, 5.0, 20.0 };
+			for (unsigned seed = 0; seed < 10; ++seed)
+			{
+				const auto track = createRandomTrack(seed, 50 + 10 * seed);
+				for (const auto nThreads : { 1u, 4u })
+				{
+					const auto paceCurves = calculatePaceCurves(track, 5.0, 7.0, minElevationDiffs_m, nThreads);
+					Assert::AreEqual(minElevationDiffs_m.size(), paceCurves.size());
+					for (size_t e = 0; e < minElevationDiffs_m.size(); ++e)
+						assertPaceCurvesEqual(calculatePaceCurve(track, 5.0, 7.0, minElevationDiffs_m[e], PaceCurveEngine::PREFIX_SUM), paceCurves[e]);
+				}
+			}
+
+			Assert::ExpectException<std::invalid_argument>([]() {
+				calculatePaceCurves(createRandomTrack(0, 10), 5.0, 7.0, { 5.0, 0.0 });
+			});
+		}
+
+		TEST_METHOD(PaceCurveCustomDistanceGrid)
+		{
+			const auto logSpaced = calculateLogSpacedDistances(100.0, 1000.0, 1);
+			Assert::AreEqual(size_t(4), logSpaced.size(), L"Unexpected number of log spaced distances");
+			Assert::AreEqual(800.0, logSpaced.back(), 1e-9);
+
+			for (unsigned seed = 0; seed < 10; ++seed)
+			{
+				const auto track = createRandomTrack(seed, 50 + 10 * seed);
+				for (const auto minElevationDiff_m : { -1000.0, 5.0 })
+				{
+					// The same grid as the linear overload
+					std::vector<double> linear;
+					for (auto distance_m = 5.0; distance_m < 10000.0; distance_m += 7.0)
+						linear.push_back(distance_m);
+
+					for (const auto engine : { PaceCurveEngine::EXHAUSTIVE, PaceCurveEngine::PREFIX_SUM })
+						assertPaceCurvesEqual(calculatePaceCurve(track, 5.0, 7.0, minElevationDiff_m, engine), calculatePaceCurve(track, linear, minElevationDiff_m, engine));
+
+					const auto grid = calculateLogSpacedDistances(1.0, 10000.0, 4);
+					const auto exhaustive = calculatePaceCurve(track, grid, minElevationDiff_m, PaceCurveEngine::EXHAUSTIVE);
+					assertPaceCurvesNearlyEqual(exhaustive, calculatePaceCurve(track, grid, minElevationDiff_m, PaceCurveEngine::PREFIX_SUM, 4));
+				}
+			}
+
+			Assert::ExpectException<std::invalid_argument>([]() {
+				calculatePaceCurve(createRandomTrack(0, 10), { 10.0, 5.0 }, 0.0);
+			});
+		}
+
+		TEST_METHOD(DurationCurveInSeconds)
+		{
+			// A point every second for 10 minutes, speeding up each step, so the best segments are at the end
+			std::vector<GpxPoint> track;
+			std::vector<double> distances_m;
+			double distance_m = 0.0;
+			for (uint64_t t_s = 0; t_s <= 600; ++t_s)
+			{
+				track.push_back(GpxPoint(distance_m * DEGREES_PER_METRE, 0.0, 0.0, 1000 * t_s));
+				distances_m.push_back(distance_m);
+				distance_m += 3.0 + 0.001 * t_s;
+			}
+
+			const auto durationCurve = calculateDurationCurve(track, { 1.0, 5.0, 60.0, 300.0, 1000.0 }, -1000.0);
+			Assert::AreEqual(size_t(4), durationCurve.size(), L"Only the last duration is longer than the track");
+			for (const auto &point : durationCurve)
+			{
+				const auto expected_m = distances_m.back() - distances_m[600 - static_cast<size_t>(point.duration_s)];
+				Assert::AreEqual(point.duration_s, point.bestPaceSegment.distanceTime.time_s, 1e-9, L"Segment time differs");
+				Assert::AreEqual(expected_m, point.bestPaceSegment.distanceTime.distance_m, 1e-6, L"Segment distance differs");
+				Assert::AreEqual(expected_m, point.distance_m, 1e-6, L"Furthest distance differs");
+			}
+		}
+
+		TEST_METHOD(DurationCurveMatchesBruteForce)
+		{
+			// Every track lasts at least 49s, and none lasts a million seconds
+			const std::vector<double> targetDurations_s = { 1.0, 5.0, 30.0, 60.0, 300.0, 1e6 };
+			std::vector<std::vector<DurationCurvePoint>> durationCurves;
+			for (unsigned seed = 0; seed < 10; ++seed)
+			{
+				const auto track = createRandomTrack(seed, 50 + 10 * seed);
+				for (const auto minElevationDiff_m : { -1000.0, 5.0 })
+				{
+					const auto durationCurve = calculateDurationCurve(track, targetDurations_s, minElevationDiff_m, 4);
+					Assert::IsTrue(durationCurve.size() < targetDurations_s.size(), L"Durations longer than the track should be dropped");
+					Assert::IsTrue(durationCurve.size() >= 3, L"Durations within the track are missing");
+
+					// Best pace of every segment lasting at least each duration, and furthest distance of every segment lasting at most it
+					const auto activity = ActivityColumns::fromGpx(track);
+					for (const auto &point : durationCurve)
+					{
+						auto best = DistTimeElev::zero();
+						auto furthest_m = 0.0;
+						for (size_t from = 0; from < track.size(); ++from)
+						{
+							for (auto to = from + 1; to < track.size(); ++to)
+							{
+								const auto segment = activity.segment(from, to);
+								if (segment.elevation.elevationDiff_m < minElevationDiff_m)
+									continue;
+
+								if (segment.distanceTime.time_s <= point.duration_s)
+									furthest_m = std::max(furthest_m, segment.distanceTime.distance_m);
+
+								if (segment.distanceTime.time_s < point.duration_s)
+									continue;
+
+								if (best.distanceTime.time_s == 0.0 || segment.distanceTime.pace_ms() > best.distanceTime.pace_ms())
+									best = segment;
+							}
+						}
+
+						Assert::AreEqual(best.distanceTime.distance_m, point.bestPaceSegment.distanceTime.distance_m, L"Segment distance differs");
+						Assert::AreEqual(best.distanceTime.time_s, point.bestPaceSegment.distanceTime.time_s, L"Segment time differs");
+						Assert::AreEqual(furthest_m, point.distance_m, L"Furthest distance differs");
+					}
+
+					if (minElevationDiff_m < 0.0)
+						durationCurves.push_back(durationCurve);
+				}
+			}
+
+			// Merged curves have the best pace of any curve for each duration
+			const auto merged = mergeDurationCurves(durationCurves);
+			for (const auto &curve : durationCurves)
+			{
+				for (const auto &point : curve)
+				{
+					const auto mergedPoint = std::find_if(merged.begin(), merged.end(), [&point](const DurationCurvePoint &p) {
+						return p.duration_s == point.duration_s;
+					});
+
+					Assert::IsTrue(mergedPoint != merged.end(), L"Duration missing from merged curve");
+					Assert::IsTrue(mergedPoint->bestPaceSegment.distanceTime.pace_ms() >= point.bestPaceSegment.distanceTime.pace_ms(), L"Merged pace is worse");
+					Assert::IsTrue(mergedPoint->distance_m >= point.distance_m, L"Merged distance is shorter");
+				}
+			}
+		}
+
+		TEST_METHOD(BestEffortsMatchGreedySearch)
+		{
+			const std::vector<double> targetDistances_m = { 10.0, 50.0, 100.0, 200.0 };
+			for (unsigned seed = 0; seed < 10; ++seed)
+			{
+				const auto track = createRandomTrack(seed, 40 + 5 * seed);
+				const auto activity = ActivityColumns::fromGpx(track);
+				for (const auto minElevationDiff_m : { -1000.0, 0.0 })
+				{
+					const auto bestEfforts = calculateBestEfforts(activity, targetDistances_m, minElevationDiff_m, 3, 4);
+
+					// The first effort is the pace curve
+					const auto paceCurve = calculatePaceCurve(activity, targetDistances_m, minElevationDiff_m);
+					Assert::AreEqual(paceCurve.size(), bestEfforts.size(), L"Unexpected number of distances");
+					for (size_t k = 0; k < paceCurve.size(); ++k)
+					{
+						Assert::AreEqual(paceCurve[k].distance_m, bestEfforts[k].distance_m, L"Distance differs");
+						Assert::AreEqual(paceCurve[k].bestPaceSegment.distanceTime.distance_m, bestEfforts[k].efforts.front().segment.distanceTime.distance_m, L"Best effort differs");
+					}
+
+					// Each effort is the best segment that doesn't overlap the ones before it
+					for (const auto &point : bestEfforts)
+					{
+						std::vector<LocatedSegment> expected;
+						for (;;)
+						{
+							bool found = false;
+							LocatedSegment best;
+							for (size_t from = 0; from < track.size(); ++from)
+							{
+								for (auto to = from + 1; to < track.size(); ++to)
+								{
+									const auto segment = activity.segment(from, to);
+									const auto overlaps = std::any_of(expected.begin(), expected.end(), [from, to](const LocatedSegment &e) {
+										return from < e.toIndex && e.fromIndex < to;
+									});
+
+									if (overlaps || segment.distanceTime.distance_m < point.distance_m || segment.elevation.elevationDiff_m < minElevationDiff_m)
+										continue;
+
+									if (!found || segment.distanceTime.pace_ms() > best.segment.distanceTime.pace_ms())
+									{
+										found = true;
+										best = LocatedSegment(segment, from, to);
+									}
+								}
+							}
+
+							if (!found || expected.size() == 3)
+								break;
+
+							expected.push_back(best);
+						}
+
+						Assert::AreEqual(expected.size(), point.efforts.size(), L"Unexpected number of efforts");
+						for (size_t e = 0; e < expected.size(); ++e)
+						{
+							Assert::AreEqual(expected[e].fromIndex, point.efforts[e].fromIndex, L"Effort start differs");
+							Assert::AreEqual(expected[e].toIndex, point.efforts[e].toIndex, L"Effort end differs");
+						}
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(ApproximatePaceCurveWithinErrorBound)
+		{
+			const auto activity = ActivityColumns::fromGpx(createRandomTrack(3, 3000));
+			const auto exact = calculatePaceCurve(activity, 50.0, 50.0, -1000.0);
+			const auto approximate = calculateApproximatePaceCurve(activity, 50.0, 50.0, 20.0);
+
+			Assert::IsTrue(approximate.nPointsUsed < activity.size() / 2, L"Too many points used");
+			Assert::AreEqual(exact.size(), approximate.paceCurve.size(), L"Pace curve sizes differ");
+			Assert::AreEqual(exact.size(), approximate.maxPaceErrors.size(), L"Unexpected number of errors");
+
+			for (size_t k = 0; k < exact.size(); ++k)
+			{
+				const auto exactPace = exact[k].bestPaceSegment.distanceTime.pace_ms();
+				const auto approximatePace = approximate.paceCurve[k].bestPaceSegment.distanceTime.pace_ms();
+				Assert::IsTrue(approximatePace <= exactPace, L"Approximate pace is faster than exact");
+				Assert::IsTrue(exactPace <= approximatePace + approximate.maxPaceErrors[k], L"Exact pace is outside the error bound");
+				Assert::IsTrue(approximate.maxPaceErrors[k] <= approximate.maxPaceError, L"Max error isn't the largest");
+			}
+
+			// The bound tightens with distance
+			const auto longestPace = approximate.paceCurve.back().bestPaceSegment.distanceTime.pace_ms();
+			Assert::IsTrue(approximate.maxPaceErrors.back() < 0.1 * longestPace, L"Error bound too loose for the longest distance");
+		}
+
+		TEST_METHOD(ApproximatePaceCurveGapInSeconds)
+		{
+			// A point every second for 10 minutes
+			std::vector<GpxPoint> track;
+			for (uint64_t t_s = 0; t_s <= 600; ++t_s)
+				track.push_back(GpxPoint(3.0 * t_s * DEGREES_PER_METRE, 0.0, 0.0, 1000 * t_s));
+
+			// Every 20th point is kept
+			const auto activity = ActivityColumns::fromGpx(track);
+			const auto approximate = calculateApproximatePaceCurve(activity, 100.0, 100.0, 20.0);
+			Assert::AreEqual(size_t(31), approximate.nPointsUsed, L"Unexpected number of points used");
+
+			// At a constant pace, every approximate segment has that pace
+			for (const auto &point : approximate.paceCurve)
+				Assert::AreEqual(3.0, point.bestPaceSegment.distanceTime.pace_ms(), 1e-6, L"Pace differs");
+		}
+	};
+}
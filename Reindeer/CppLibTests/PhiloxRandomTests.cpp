@@ -0,0 +1,156 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "ReindeerLib/PhiloxRandom.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	constexpr PhiloxKey TEST_KEY = { 0x12345678, 0x9abcdef0 };
+
+	std::vector<float> fill(size_t n, uint64_t stream, uint64_t firstIndex, SimdLevel simdLevel)
+	{
+		std::vector<float> values(n, -1000.f);
+		fillGaussian(values.data(), n, 0.f, 1.f, TEST_KEY, stream, firstIndex, simdLevel);
+		return values;
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(PhiloxRandomTests)
+	{
+	public:
+
+		// Known answers from the Random123 library
+		TEST_METHOD(Philox4x32KnownAnswers)
+		{
+			Assert::IsTrue(PhiloxCounter{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } == philox4x32({ 0, 0, 0, 0 }, { 0, 0 }));
+			Assert::IsTrue(PhiloxCounter{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } ==
+				philox4x32({ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }));
+			Assert::IsTrue(PhiloxCounter{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } ==
+				philox4x32({ 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }));
+		}
+
+		TEST_METHOD(GaussianSameForEachSimdLevel)
+		{
+			const auto supportedLevel = detectSimdLevel();
+
+			// Including a stream and first index where the block number's low word wraps
+			for (const auto firstIndex : { 0ULL, 1ULL, 3ULL, 4ULL, 7ULL, 0x3fffffff0ULL })
+			{
+				for (const auto n : { 0, 1, 3, 4, 5, 31, 32, 33, 100, 1001 })
+				{
+					const auto expected = fill(n, 5, firstIndex, SimdLevel::SCALAR);
+					for (const auto simdLevel : { SimdLevel::SSE2, SimdLevel::AVX2 })
+					{
+						if (simdLevel > supportedLevel)
+							continue;
+
+						const auto values = fill(n, 5, firstIndex, simdLevel);
+						for (size_t i = 0; i < values.size(); ++i)
+							Assert::AreEqual(expected[i], values[i], L"Value differs from the scalar value");
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(GaussianFilledInPieces)
+		{
+			const auto whole = fill(1000, 1, 0, detectSimdLevel());
+
+			std::vector<float> pieces(whole.size());
+			size_t filled = 0;
+			for (const auto pieceSize : { 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144, 233, 392 })
+			{
+				fillGaussian(pieces.data() + filled, pieceSize, 0.f, 1.f, TEST_KEY, 1, filled);
+				filled += pieceSize;
+			}
+			Assert::AreEqual(whole.size(), filled);
+
+			for (size_t i = 0; i < whole.size(); ++i)
+				Assert::AreEqual(whole[i], pieces[i], L"Piece differs from the whole stream");
+
+			// Other streams and keys are different
+			Assert::IsFalse(whole == fill(1000, 2, 0, detectSimdLevel()));
+			std::vector<float> otherKey(whole.size());
+			fillGaussian(otherKey.data(), otherKey.size(), 0.f, 1.f, { 1, 2 }, 1, 0);
+			Assert::IsFalse(whole == otherKey);
+		}
+
+		TEST_METHOD(GaussianDistribution)
+		{
+			const float mean = 3.f;
+			const float stdDev = 2.f;
+			std::vector<float> values(1 << 22);
+			fillGaussian(values.data(), values.size(), mean, stdDev, TEST_KEY, 0);
+
+			// Moments, and the fraction within 1, 2 and 3 standard deviations
+			double sum = 0.0;
+			double sumSquares = 0.0;
+			size_t within[3] = {};
+			for (const auto v : values)
+			{
+				sum += v;
+				sumSquares += double(v) * v;
+				const auto deviations = std::abs(v - mean) / stdDev;
+				for (size_t d = 0; d < 3; ++d)
+					within[d] += deviations < d + 1 ? 1 : 0;
+			}
+
+			const auto n = static_cast<double>(values.size());
+			const auto sampleMean = sum / n;
+			Assert::AreEqual(double(mean), sampleMean, 0.005);
+			Assert::AreEqual(double(stdDev), std::sqrt(sumSquares / n - sampleMean * sampleMean), 0.005);
+
+			const double expectedWithin[3] = { 0.682689, 0.954500, 0.997300 };
+			for (size_t d = 0; d < 3; ++d)
+				Assert::AreEqual(expectedWithin[d], within[d] / n, 0.001);
+		}
+
+		TEST_METHOD(GaussianBenchmark)
+		{
+			const size_t nValues = 1 << 22;
+			std::vector<float> values(nValues);
+
+			const auto time_ms = [&values](const auto &fillFn)
+			{
+				const auto start = std::chrono::steady_clock::now();
+				fillFn();
+				const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+				double checksum = 0.0;
+				for (const auto v : values)
+					checksum += v;
+				return std::make_pair(elapsed.count(), checksum);
+			};
+
+			std::mt19937 randomEng(1);
+			std::normal_distribution<float> randomNormal(0.f, 1.f);
+			const auto stdLib = time_ms([&]()
+			{
+				for (auto &v : values)
+					v = randomNormal(randomEng);
+			});
+
+			const auto philox = time_ms([&]()
+			{
+				fillGaussian(values.data(), values.size(), 0.f, 1.f, TEST_KEY, 0);
+			});
+
+			char message[128];
+			std::snprintf(message, sizeof(message), "%zu values: std::normal_distribution %.1f ms, fillGaussian %.1f ms",
+				nValues, stdLib.first, philox.first);
+			Logger::WriteMessage(message);
+		}
+	};
+}
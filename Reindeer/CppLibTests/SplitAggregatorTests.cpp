@@ -0,0 +1,171 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "ReindeerLib/SplitAggregator.h"
+
+#include "TestTracks.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	DistTimeElev totalOf(const std::vector<GpxPoint> &track)
+	{
+		auto total = DistTimeElev::zero();
+		for (size_t i = 1; i < track.size(); ++i)
+			total = DistTimeElev::sum(total, DistTimeElev::fromGpx(track[i - 1], track[i]));
+
+		return total;
+	}
+
+	void assertNearlyEqual(const DistTimeElev &expected, const DistTimeElev &actual)
+	{
+		Assert::AreEqual(expected.distanceTime.distance_m, actual.distanceTime.distance_m, 1e-6);
+		Assert::AreEqual(expected.distanceTime.time_s, actual.distanceTime.time_s, 1e-6 * std::abs(expected.distanceTime.time_s));
+		Assert::AreEqual(expected.elevation.elevationDiff_m, actual.elevation.elevationDiff_m, 1e-6);
+		Assert::AreEqual(expected.elevation.cumulativeElevation_m, actual.elevation.cumulativeElevation_m, 1e-6);
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(SplitAggregatorTests)
+	{
+	public:
+
+		TEST_METHOD(SplitsDivideSteps)
+		{
+			// 300m every minute, climbing 30m, so the first km ends a third of the way through the fourth step
+			std::vector<GpxPoint> track;
+			for (int i = 0; i < 8; ++i)
+				track.push_back(GpxPoint(300.0 * i * DEGREES_PER_METRE, 0.0, 30.0 * i, 60000 * i));
+
+			SplitAggregator aggregator(SplitAxis::DISTANCE, 1000.0);
+			std::vector<Split> splits;
+			aggregator.append(track.data(), track.size(), splits);
+
+			Assert::AreEqual(size_t(2), splits.size());
+			for (const auto &split : splits)
+			{
+				Assert::AreEqual(1000.0, split.distTimeElev.distanceTime.distance_m, 1e-6);
+				Assert::AreEqual(200.0, split.distTimeElev.distanceTime.time_s, 1e-9);
+				Assert::AreEqual(100.0, split.distTimeElev.elevation.elevationDiff_m, 1e-6);
+				Assert::AreEqual(split.distTimeElev.distanceTime.time_s, split.movingTime_s);
+			}
+
+			Assert::AreEqual(100.0, aggregator.current().distTimeElev.distanceTime.distance_m, 1e-6);
+			Assert::AreEqual(size_t(2), aggregator.completedCount());
+			Assert::AreEqual(size_t(8), aggregator.pointCount());
+		}
+
+		TEST_METHOD(StepAcrossSeveralSplits)
+		{
+			SplitAggregator aggregator(SplitAxis::DISTANCE, 100.0);
+			std::vector<Split> splits;
+			aggregator.append(GpxPoint(0.0, 0.0, 0.0, 0), splits);
+			aggregator.append(GpxPoint(350.0 * DEGREES_PER_METRE, 0.0, 0.0, 1000), splits);
+
+			Assert::AreEqual(size_t(3), splits.size());
+			for (const auto &split : splits)
+				Assert::AreEqual(100.0, split.distTimeElev.distanceTime.distance_m, 1e-6);
+			Assert::AreEqual(50.0, aggregator.current().distTimeElev.distanceTime.distance_m, 1e-6);
+		}
+
+		TEST_METHOD(TimeSplitsInSeconds)
+		{
+			// 30m every 10s for an hour, stopped from 10 to 15 minutes in
+			std::vector<GpxPoint> track;
+			double distance_m = 0.0;
+			for (uint64_t t_s = 0; t_s <= 3600; t_s += 10)
+			{
+				track.push_back(GpxPoint(distance_m * DEGREES_PER_METRE, 0.0, 0.0, 1000 * t_s));
+				if (t_s < 600 || t_s >= 900)
+					distance_m += 30.0;
+			}
+
+			SplitAggregator aggregator(SplitAxis::TIME, 300.0, 0.5);
+			std::vector<Split> splits;
+			aggregator.append(track.data(), track.size(), splits);
+
+			// The last point ends the last split
+			Assert::AreEqual(size_t(12), splits.size());
+			for (size_t i = 0; i < splits.size(); ++i)
+			{
+				const auto stopped = i == 2;
+				Assert::AreEqual(300.0, splits[i].distTimeElev.distanceTime.time_s, 1e-9);
+				Assert::AreEqual(stopped ? 0.0 : 900.0, splits[i].distTimeElev.distanceTime.distance_m, 1e-6);
+				Assert::AreEqual(stopped ? 0.0 : 300.0, splits[i].movingTime_s, 1e-9);
+			}
+
+			Assert::AreEqual(0.0, aggregator.current().distTimeElev.distanceTime.time_s);
+		}
+
+		TEST_METHOD(TimeGoingBackwardsTakesNoTime)
+		{
+			// 10m every 10s, with the clock stepping back 5s after 20s and repeating a time at 35s
+			std::vector<GpxPoint> track;
+			const uint64_t times_s[] = { 0, 10, 20, 15, 25, 35, 35, 45 };
+			for (size_t i = 0; i < 8; ++i)
+				track.push_back(GpxPoint(10.0 * i * DEGREES_PER_METRE, 0.0, 0.0, 1000 * times_s[i]));
+
+			for (const auto axis : { SplitAxis::TIME, SplitAxis::DISTANCE })
+			{
+				SplitAggregator aggregator(axis, 10.0);
+				std::vector<Split> splits;
+				aggregator.append(track.data(), track.size(), splits);
+
+				auto total = aggregator.current().distTimeElev;
+				for (const auto &split : splits)
+					total = DistTimeElev::sum(total, split.distTimeElev);
+
+				Assert::AreEqual(50.0, total.distanceTime.time_s, 1e-9, L"Backwards step should take no time");
+				Assert::AreEqual(70.0, total.distanceTime.distance_m, 1e-6);
+				Assert::AreEqual(axis == SplitAxis::TIME ? size_t(5) : size_t(7), splits.size());
+			}
+		}
+
+		TEST_METHOD(SplitsAddUpToTotal)
+		{
+			// With stops, so no split is all moving
+			RandomTrackShape shape;
+			shape.maxStep_m = 30.0;
+			shape.maxClimb_m = 1;
+			shape.stopEvery = 8;
+			const auto track = createRandomTrack(0, 5000, shape);
+			const auto total = totalOf(track);
+
+			for (const auto axis : { SplitAxis::DISTANCE, SplitAxis::TIME })
+			{
+				const auto interval = axis == SplitAxis::DISTANCE ? 1000.0 : 300.0;
+				SplitAggregator aggregator(axis, interval, 0.0);
+
+				std::vector<Split> splits;
+				for (const auto &p : track)
+					aggregator.append(p, splits);
+
+				Assert::AreEqual(splits.size(), aggregator.completedCount());
+				const auto axisTotal = axis == SplitAxis::DISTANCE ? total.distanceTime.distance_m : total.distanceTime.time_s;
+				Assert::AreEqual(static_cast<size_t>(axisTotal / interval), splits.size(), L"Unexpected number of splits");
+				for (const auto &split : splits)
+				{
+					const auto &distanceTime = split.distTimeElev.distanceTime;
+					Assert::AreEqual(interval, axis == SplitAxis::DISTANCE ? distanceTime.distance_m : distanceTime.time_s, 1e-6 * interval);
+					Assert::IsTrue(split.movingTime_s < distanceTime.time_s, L"Stops shouldn't count as moving");
+				}
+
+				auto sum = aggregator.current().distTimeElev;
+				for (const auto &split : splits)
+					sum = DistTimeElev::sum(sum, split.distTimeElev);
+				assertNearlyEqual(total, sum);
+			}
+
+			Assert::ExpectException<std::invalid_argument>([]() { SplitAggregator(SplitAxis::TIME, 0.0); });
+		}
+	};
+}
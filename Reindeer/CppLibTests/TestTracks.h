@@ -0,0 +1,55 @@
+#pragma once
+
+#include <random>
+#include <vector>
+
+#include "ReindeerLib/ActivityStructures.h"
+
+namespace CppLibTests
+{
+	// Degrees of longitude per metre along the equator
+	constexpr double DEGREES_PER_METRE = 1.0 / (reindeer::EARTH_RADIUS_m * reindeer::RADIANS_PER_DEGREE);
+
+	struct RandomTrackShape
+	{
+		double maxStep_m = 12.0;
+		uint64_t maxInterval_ms = 5000;
+		// Climbs are whole metres, so elevation sums are exact however they're added up
+		int maxClimb_m = 3;
+		uint64_t startDateTime_ms = 0;
+		// Every stopEvery'th step doesn't move, and every repeatTimeEvery'th step has no time (0 for never)
+		size_t stopEvery = 0;
+		size_t repeatTimeEvery = 0;
+	};
+
+	// Track along the equator with random step lengths, so no two segments have exactly the same pace
+	// Points are 1s to shape.maxInterval_ms apart
+	inline std::vector<reindeer::GpxPoint> createRandomTrack(unsigned seed, size_t nPoints, const RandomTrackShape &shape = RandomTrackShape())
+	{
+		std::mt19937 randomEng(seed);
+		std::uniform_real_distribution<double> randomStep_m(0.0, shape.maxStep_m);
+		std::uniform_int_distribution<uint64_t> randomInterval_ms(1000, shape.maxInterval_ms);
+		std::uniform_int_distribution<int> randomClimb_m(-shape.maxClimb_m, shape.maxClimb_m);
+
+		std::vector<reindeer::GpxPoint> track;
+		double longitude = 0.0;
+		double elevation_m = 100.0;
+		uint64_t dateTime_ms = shape.startDateTime_ms;
+		for (size_t i = 0; i < nPoints; ++i)
+		{
+			track.push_back(reindeer::GpxPoint(longitude, 0.0, elevation_m, dateTime_ms));
+
+			const auto step_m = randomStep_m(randomEng);
+			if (shape.stopEvery == 0 || i % shape.stopEvery != shape.stopEvery - 1)
+				longitude += step_m * DEGREES_PER_METRE;
+
+			const auto interval_ms = randomInterval_ms(randomEng);
+			if (shape.repeatTimeEvery == 0 || i % shape.repeatTimeEvery != shape.repeatTimeEvery - 1)
+				dateTime_ms += interval_ms;
+
+			elevation_m += randomClimb_m(randomEng);
+		}
+
+		return track;
+	}
+}
@@ -0,0 +1,151 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ReindeerLib/Timestamp.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	uint64_t parse(const std::string &text)
+	{
+		return parseIso8601_ms(text.data(), text.data() + text.size());
+	}
+
+	// The standard library route, via std::get_time and _mkgmtime (which ignore the fraction and zone)
+	uint64_t parseWithStdLib(const std::string &text)
+	{
+		std::tm tm = {};
+		std::istringstream stream(text);
+		stream >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+		const auto seconds = _mkgmtime(&tm);
+
+		int millisecond = 0;
+		if (text.size() > 20 && text[19] == '.')
+			millisecond = std::stoi(text.substr(20, 3));
+
+		return static_cast<uint64_t>(seconds) * 1000 + millisecond;
+	}
+
+	std::vector<std::string> createRandomTimestamps(size_t n)
+	{
+		std::mt19937 randomEng(0);
+		std::uniform_int_distribution<int> randomYear(1970, 2100);
+		std::uniform_int_distribution<int> randomMonth(1, 12);
+		std::uniform_int_distribution<int> randomDay(1, 28);
+		std::uniform_int_distribution<int> randomSecondOfDay(0, 86399);
+		std::uniform_int_distribution<int> randomMillisecond(0, 999);
+
+		std::vector<std::string> timestamps;
+		for (size_t i = 0; i < n; ++i)
+		{
+			const auto secondOfDay = randomSecondOfDay(randomEng);
+			char text[32];
+			std::snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+				randomYear(randomEng), randomMonth(randomEng), randomDay(randomEng),
+				secondOfDay / 3600, secondOfDay / 60 % 60, secondOfDay % 60, randomMillisecond(randomEng));
+			timestamps.push_back(text);
+		}
+
+		return timestamps;
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(TimestampTests)
+	{
+	public:
+
+		TEST_METHOD(ParseIso8601)
+		{
+			Assert::AreEqual(uint64_t(0), parse("1970-01-01T00:00:00Z"));
+			Assert::AreEqual(uint64_t(1525170030000), parse("2018-05-01T10:20:30Z"));
+			Assert::AreEqual(uint64_t(1525170030123), parse("2018-05-01T10:20:30.123Z"));
+			Assert::AreEqual(uint64_t(951782400000), parse("2000-02-29T00:00:00Z"));
+
+			// Slow path
+			Assert::AreEqual(uint64_t(1525170030123), parse("2018-05-01T10:20:30.123456Z"));
+			Assert::AreEqual(uint64_t(1525170030100), parse("2018-05-01T10:20:30.1Z"));
+			Assert::AreEqual(uint64_t(1525170030123), parse("2018-05-01T11:20:30.123+01:00"));
+			Assert::AreEqual(uint64_t(1525170030000), parse("2018-05-01T05:50:30-0430"));
+			Assert::AreEqual(uint64_t(1525170030000), parse("2018-05-01T10:20:30"));
+			Assert::AreEqual(uint64_t(1525170030000), parse("2018-05-01 10:20:30z"));
+
+			for (const auto invalid : { "", "2018-05-01", "2018-13-01T10:20:30Z", "2018-05-01T24:20:30Z", "2018-05-01T10:20:30.Z",
+				"2018-05-01X10:20:30Z", "2018-05-01T10:20:30+1", "2018-05-01T10:20:30Zextra", "2O18-05-01T10:20:30Z" })
+			{
+				Assert::ExpectException<std::runtime_error>([invalid]() { parse(invalid); });
+			}
+		}
+
+		TEST_METHOD(ParseIso8601DaysOfMonth)
+		{
+			Assert::AreEqual(uint64_t(1709164800000), parse("2024-02-29T00:00:00Z"));
+			Assert::AreEqual(uint64_t(1525046400000), parse("2018-04-30T00:00:00Z"));
+			Assert::AreEqual(uint64_t(1546300799999), parse("2018-12-31T23:59:59.999Z"));
+
+			// Both parsers, as the fraction and separator choose the path
+			for (const auto invalid : { "2018-02-29T00:00:00Z", "1900-02-29T00:00:00Z", "2100-02-29T00:00:00.000Z",
+				"2018-04-31T00:00:00Z", "2018-06-31T00:00:00.000Z", "2018-02-30 10:20:30", "2018-11-31T10:20:30.1Z" })
+			{
+				Assert::ExpectException<std::runtime_error>([invalid]() { parse(invalid); });
+			}
+		}
+
+		TEST_METHOD(ParseIso8601BeforeEpoch)
+		{
+			Assert::AreEqual(uint64_t(3600000), parse("1970-01-01T00:00:00-01:00"));
+			Assert::AreEqual(uint64_t(0), parse("1970-01-01T01:00:00+01:00"));
+
+			for (const auto invalid : { "1969-12-31T23:59:59Z", "1969-12-31T23:59:59.999Z", "1900-01-01T00:00:00Z",
+				"1970-01-01T00:30:00+01:00", "1970-01-01T00:00:00.5+00:01" })
+			{
+				Assert::ExpectException<std::runtime_error>([invalid]() { parse(invalid); });
+			}
+		}
+
+		TEST_METHOD(ParseIso8601MatchesStdLib)
+		{
+			for (const auto &timestamp : createRandomTimestamps(10000))
+				Assert::AreEqual(parseWithStdLib(timestamp), parse(timestamp));
+		}
+
+		TEST_METHOD(ParseIso8601Benchmark)
+		{
+			const auto timestamps = createRandomTimestamps(200000);
+
+			const auto time_ms = [&timestamps](const auto &parseFn)
+			{
+				uint64_t checksum = 0;
+				const auto start = std::chrono::steady_clock::now();
+				for (const auto &timestamp : timestamps)
+					checksum += parseFn(timestamp);
+
+				const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+				return std::make_pair(elapsed.count(), checksum);
+			};
+
+			const auto stdLib = time_ms(parseWithStdLib);
+			const auto fast = time_ms(parse);
+			Assert::AreEqual(stdLib.second, fast.second, L"Checksums differ");
+
+			char message[128];
+			std::snprintf(message, sizeof(message), "%zu timestamps: std::get_time %.1f ms, parseIso8601_ms %.1f ms",
+				timestamps.size(), stdLib.first, fast.first);
+			Logger::WriteMessage(message);
+		}
+	};
+}
@@ -0,0 +1,177 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include "ReindeerLib/TrackResampler.h"
+
+#include "TestTracks.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace
+{
+	// Output columns with room for capacity samples
+	struct ResampledTrack
+	{
+		std::vector<double> time_s;
+		std::vector<double> distance_m;
+		std::vector<double> longitude;
+		std::vector<double> latitude;
+		std::vector<double> elevation_m;
+
+		explicit ResampledTrack(size_t capacity) :
+			time_s(capacity, -1.0), distance_m(capacity, -1.0), longitude(capacity, -1.0), latitude(capacity, -1.0), elevation_m(capacity, -1.0)
+		{
+
+		}
+
+		ResampledColumns columns()
+		{
+			ResampledColumns columns;
+			columns.time_s = time_s.data();
+			columns.distance_m = distance_m.data();
+			columns.longitude = longitude.data();
+			columns.latitude = latitude.data();
+			columns.elevation_m = elevation_m.data();
+			columns.capacity = time_s.size();
+			return columns;
+		}
+	};
+
+	// 1 to 10 second samples, with some pauses and repeated timestamps
+	std::vector<GpxPoint> createTrack(unsigned seed, size_t nPoints)
+	{
+		CppLibTests::RandomTrackShape shape;
+		shape.maxStep_m = 40.0;
+		shape.maxInterval_ms = 10000;
+		shape.maxClimb_m = 2;
+		shape.startDateTime_ms = 1559374200000;
+		shape.stopEvery = 50;
+		shape.repeatTimeEvery = 70;
+		return CppLibTests::createRandomTrack(seed, nPoints, shape);
+	}
+}
+
+namespace CppLibTests
+{
+	TEST_CLASS(TrackResamplerTests)
+	{
+	public:
+
+		TEST_METHOD(ResampleOnTime)
+		{
+			const std::vector<GpxPoint> track = {
+				GpxPoint(0.0, 1.0, 10.0, 5000),
+				GpxPoint(10.0 * DEGREES_PER_METRE, 1.0, 20.0, 6000),
+				GpxPoint(40.0 * DEGREES_PER_METRE, 1.0, 0.0, 9000) };
+
+			TrackResampler resampler;
+			ResampledTrack resampled(10);
+			Assert::AreEqual(size_t(5), resampler.resampleOnTime(track, 1.0, resampled.columns()));
+
+			const std::vector<double> expectedTime_s = { 0.0, 1.0, 2.0, 3.0, 4.0 };
+			const std::vector<double> expectedLongitude_m = { 0.0, 10.0, 20.0, 30.0, 40.0 };
+			const std::vector<double> expectedElevation_m = { 10.0, 20.0, 20.0 * 2 / 3, 20.0 / 3, 0.0 };
+			for (size_t k = 0; k < 5; ++k)
+			{
+				Assert::AreEqual(expectedTime_s[k], resampled.time_s[k]);
+				Assert::AreEqual(expectedLongitude_m[k], resampled.longitude[k] / DEGREES_PER_METRE, 1e-9);
+				Assert::AreEqual(1.0, resampled.latitude[k]);
+				Assert::AreEqual(expectedElevation_m[k], resampled.elevation_m[k], 1e-12);
+			}
+
+			// Untouched beyond the samples
+			Assert::AreEqual(-1.0, resampled.time_s[5]);
+		}
+
+		TEST_METHOD(ResampleOnDistance)
+		{
+			const std::vector<GpxPoint> track = {
+				GpxPoint(0.0, 0.0, 0.0, 0),
+				GpxPoint(100.0 * DEGREES_PER_METRE, 0.0, 10.0, 20000),
+				GpxPoint(100.0 * DEGREES_PER_METRE, 0.0, 10.0, 80000),
+				GpxPoint(250.0 * DEGREES_PER_METRE, 0.0, 40.0, 110000) };
+
+			TrackResampler resampler;
+			ResampledTrack resampled(3);
+			Assert::AreEqual(size_t(3), resampler.resampleOnDistance(track, 100.0, resampled.columns()));
+
+			// The sample at 100m takes the last point there, the end of the stop
+			Assert::AreEqual(100.0, resampled.distance_m[1]);
+			Assert::AreEqual(0.0, resampled.time_s[0]);
+			Assert::AreEqual(80.0, resampled.time_s[1], 1e-9);
+			Assert::AreEqual(100.0, resampled.time_s[2], 1e-9);
+			Assert::AreEqual(30.0, resampled.elevation_m[2], 1e-9);
+		}
+
+		TEST_METHOD(CapacityAndEdgeCases)
+		{
+			const auto track = createTrack(0, 100);
+			TrackResampler resampler;
+
+			// Too small, so nothing is written
+			ResampledTrack tooSmall(3);
+			const auto nSamples = resampler.resampleOnTime(track, 5.0, tooSmall.columns());
+			Assert::IsTrue(nSamples > 3, L"Expected more samples than capacity");
+			Assert::AreEqual(-1.0, tooSmall.time_s[0]);
+			Assert::AreEqual(nSamples, resampler.resampleOnTime(track, 5.0, ResampledColumns()));
+
+			// Only some columns
+			std::vector<double> elevation_m(nSamples);
+			ResampledColumns columns;
+			columns.elevation_m = elevation_m.data();
+			columns.capacity = elevation_m.size();
+			Assert::AreEqual(nSamples, resampler.resampleOnTime(track, 5.0, columns));
+			Assert::AreEqual(track.front().elevation_m, elevation_m.front());
+
+			ResampledTrack single(1);
+			Assert::AreEqual(size_t(1), resampler.resampleOnDistance({ GpxPoint(1.0, 2.0, 3.0, 4) }, 10.0, single.columns()));
+			Assert::AreEqual(1.0, single.longitude[0]);
+			Assert::AreEqual(0.0, single.time_s[0]);
+			Assert::AreEqual(size_t(0), resampler.resampleOnTime({}, 1.0, single.columns()));
+
+			Assert::ExpectException<std::invalid_argument>([&resampler, &track]() { resampler.resampleOnTime(track, 0.0, ResampledColumns()); });
+		}
+
+		TEST_METHOD(SameForEachSimdLevel)
+		{
+			const auto supportedLevel = detectSimdLevel();
+			for (const auto nPoints : { 2, 3, 5, 100, 1000 })
+			{
+				const auto track = createTrack(nPoints, nPoints);
+				for (const auto onTime : { true, false })
+				{
+					const auto resample = [&track, onTime](TrackResampler &resampler, ResampledTrack &resampled)
+					{
+						return onTime ?
+							resampler.resampleOnTime(track, 1.0, resampled.columns()) :
+							resampler.resampleOnDistance(track, 3.0, resampled.columns());
+					};
+
+					TrackResampler scalarResampler(SimdLevel::SCALAR);
+					ResampledTrack sizeOnly(0);
+					ResampledTrack expected(resample(scalarResampler, sizeOnly));
+					resample(scalarResampler, expected);
+
+					for (const auto simdLevel : { SimdLevel::SSE2, SimdLevel::AVX2 })
+					{
+						if (simdLevel > supportedLevel)
+							continue;
+
+						TrackResampler resampler(simdLevel);
+						ResampledTrack resampled(expected.time_s.size());
+						resample(resampler, resampled);
+						Assert::IsTrue(expected.time_s == resampled.time_s, L"Time differs between SIMD levels");
+						Assert::IsTrue(expected.distance_m == resampled.distance_m, L"Distance differs between SIMD levels");
+						Assert::IsTrue(expected.longitude == resampled.longitude, L"Longitude differs between SIMD levels");
+						Assert::IsTrue(expected.elevation_m == resampled.elevation_m, L"Elevation differs between SIMD levels");
+					}
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,84 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "ReindeerLib/TripleBuffer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace reindeer;
+
+namespace CppLibTests
+{
+	TEST_CLASS(TripleBufferTests)
+	{
+	public:
+
+		TEST_METHOD(LatestFrame)
+		{
+			TripleBuffer<int> frames;
+			Assert::AreEqual(0, frames.latest());
+			Assert::AreEqual(0, frames.lastPublished());
+
+			frames.back() = 1;
+			frames.publish();
+			Assert::AreEqual(1, frames.lastPublished());
+
+			// The reader's frame stays the same until it asks again
+			const auto &frame = frames.latest();
+			Assert::AreEqual(1, frame);
+			for (int i = 2; i <= 5; ++i)
+			{
+				frames.back() = i;
+				frames.publish();
+				Assert::AreEqual(1, frame);
+			}
+
+			Assert::AreEqual(5, frames.latest());
+			Assert::AreEqual(5, frames.latest());
+		}
+
+		TEST_METHOD(ConcurrentReader)
+		{
+			// Every element of a frame is its frame number, so a torn frame would show
+			constexpr int nFrames = 20000;
+			TripleBuffer<std::vector<int>> frames;
+			std::atomic<bool> writerDone{ false };
+
+			std::thread writer([&frames, &writerDone]()
+			{
+				for (int frame = 1; frame <= nFrames; ++frame)
+				{
+					auto &back = frames.back();
+					back.assign(1000, 0);
+					for (auto &v : back)
+						v = frame;
+					frames.publish();
+				}
+				writerDone = true;
+			});
+
+			int lastFrame = 0;
+			bool consistent = true;
+			for (bool done = false; !done;)
+			{
+				done = writerDone;
+				const auto &frame = frames.latest();
+				if (frame.empty())
+					continue;
+
+				for (const auto v : frame)
+					consistent = consistent && v == frame.front();
+				consistent = consistent && frame.front() >= lastFrame;
+				lastFrame = frame.front();
+			}
+			writer.join();
+
+			Assert::IsTrue(consistent, L"The reader saw a frame being written or an older frame");
+			Assert::AreEqual(nFrames, lastFrame, L"The reader should end on the last frame");
+		}
+	};
+}
@@ -17,6 +17,7 @@ namespace
 	constexpr auto simulationWidth = 500.f;
 	constexpr auto simulationHeight = 500.f;
 	constexpr size_t nPoints = 100'000;
+	constexpr auto updateInterval = std::chrono::milliseconds(10);
 }
 
 QtPointRenderView::QtPointRenderView(QWidget *parent) :
@@ -25,17 +26,50 @@ mouseDownTimer(std::make_unique<QTimer>(this)),
 lastPaintClockTime(std::chrono::steady_clock::now()),
 simulator(std::make_unique<reindeer::DiffusionSimulator>())
 {
-	startUpdateTimer(std::chrono::milliseconds(10));
+	startUpdateTimer(updateInterval);
 
 	// When the mouse is down do updates on a timer so we follow it as quickly as possible
 	connect(mouseDownTimer.get(), &QTimer::timeout, this, &QtPointRenderView::onMouseDownTimer);
+
+	simulationThread = std::thread(&QtPointRenderView::runSimulation, this);
 }
 
-QtPointRenderView::~QtPointRenderView() = default;
+QtPointRenderView::~QtPointRenderView()
+{
+	stopSimulation = true;
+	simulationThread.join();
+}
 
 void QtPointRenderView::initPoints()
 {
-	simulator->initialise(nPoints, simulationWidth, simulationHeight);
+	// The simulation thread is the only one allowed to change the simulator
+	resetPointsRequested = true;
+}
+
+void QtPointRenderView::runSimulation()
+{
+	while (!stopSimulation)
+	{
+		// Step no more often than the view is drawn
+		auto const nextUpdateTime = std::chrono::steady_clock::now() + updateInterval;
+
+		if (resetPointsRequested.exchange(false))
+			simulator->initialise(nPoints, simulationWidth, simulationHeight);
+
+		if (doPositionAndColourUpdates)
+		{
+			auto const timings = simulator->update();
+			lastUpdatePositionTimeTaken = timings.updatePositionTime;
+			lastUpdateColourTimeTaken = timings.updateColourTime;
+		}
+		else
+		{
+			lastUpdatePositionTimeTaken = std::chrono::nanoseconds{};
+			lastUpdateColourTimeTaken = std::chrono::nanoseconds{};
+		}
+
+		std::this_thread::sleep_until(nextUpdateTime);
+	}
 }
 
 void QtPointRenderView::setDiffusePoints(bool diffuse)
@@ -96,18 +130,6 @@ void QtPointRenderView::resizeGL(int w, int h)
 
 void QtPointRenderView::doOpenGLDrawing()
 {
-	if (doPositionAndColourUpdates)
-	{
-		auto const timings = simulator->update();
-		lastUpdatePositionTimeTaken = timings.updatePositionTime;
-		lastUpdateColourTimeTaken = timings.updateColourTime;
-	}
-	else
-	{
-		lastUpdatePositionTimeTaken = {};
-		lastUpdateColourTimeTaken = {};
-	}
-
 	auto const preOpenGL = std::chrono::steady_clock::now();
 
 	// Start drawing
@@ -135,17 +157,15 @@ void QtPointRenderView::doOpenGLDrawing()
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glEnableClientState(GL_COLOR_ARRAY);
 
-	simulator->data.lockedModify([](reindeer::DiffusionSimulator::DataT &data)
+	// The latest frame isn't changed until we next ask for one, so no lock is needed
+	for (auto const &d : simulator->latest())
 	{
-		for (auto &d : data)
-		{
-			assert(d.colours.size() == d.positions.size() * 3);
+		assert(d.colours.size() == d.positions.size() * 3);
 
-			glVertexPointer(3, GL_FLOAT, 0, d.positions.data());
-			glColorPointer(3, GL_UNSIGNED_BYTE, 0, d.colours.data());
-			glDrawArrays(GL_POINTS, 0, d.positions.size());
-		}
-	});
+		glVertexPointer(3, GL_FLOAT, 0, d.positions.data());
+		glColorPointer(3, GL_UNSIGNED_BYTE, 0, d.colours.data());
+		glDrawArrays(GL_POINTS, 0, d.positions.size());
+	}
 
 	glDisableClientState(GL_VERTEX_ARRAY);
 	glDisableClientState(GL_COLOR_ARRAY);
@@ -178,8 +198,8 @@ void QtPointRenderView::doQPainterDrawing()
 		L"OpenGL draw time: %.3f ms\n"
 		L"FPS: %.2f",
 		std::chrono::steady_clock::now().time_since_epoch().count(),
-		static_cast<float>(lastUpdatePositionTimeTaken.count()) / 1e6,
-		static_cast<float>(lastUpdateColourTimeTaken.count()) / 1e6,
+		static_cast<float>(lastUpdatePositionTimeTaken.load().count()) / 1e6,
+		static_cast<float>(lastUpdateColourTimeTaken.load().count()) / 1e6,
 		static_cast<float>(lastOpenGLDrawTimeTaken.count()) / 1e6,
 		fps);
 
@@ -3,7 +3,9 @@
 #include "QtBaseOpenGLView.h"
 
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <thread>
 
 #include "ReindeerLib/XYZ.hpp"
 
@@ -40,8 +42,8 @@ private:
 	// Update timings
 	std::chrono::steady_clock::time_point lastPaintClockTime;
 	std::chrono::nanoseconds lastOpenGLDrawTimeTaken = {};
-	std::chrono::nanoseconds lastUpdatePositionTimeTaken = {};
-	std::chrono::nanoseconds lastUpdateColourTimeTaken = {};
+	std::atomic<std::chrono::nanoseconds> lastUpdatePositionTimeTaken{ std::chrono::nanoseconds{} };
+	std::atomic<std::chrono::nanoseconds> lastUpdateColourTimeTaken{ std::chrono::nanoseconds{} };
 	float smoothedDrawInterval_s = {};
 
 	// View info
@@ -65,7 +67,13 @@ private:
 	const std::unique_ptr<QTimer> mouseDownTimer;
 
 	// Options
-	bool doPositionAndColourUpdates = false;
+	std::atomic<bool> doPositionAndColourUpdates{ false };
 
 	const std::unique_ptr<reindeer::DiffusionSimulator> simulator;
+
+	// The simulation steps on its own thread, and drawing takes its latest frame without waiting for a step
+	void runSimulation();
+	std::atomic<bool> resetPointsRequested{ false };
+	std::atomic<bool> stopSimulation{ false };
+	std::thread simulationThread;
 };
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "ActivityColumns.h"
+
+#include "GeoDistance.h"
+
+#include <numeric>
+
+using namespace reindeer;
+
+ActivityColumns ActivityColumns::fromGpx(const std::vector<GpxPoint> &gpxData)
+{
+	ActivityColumns columns;
+	if (gpxData.empty())
+		return columns;
+
+	const auto nPoints = gpxData.size();
+	columns.distance_m.resize(nPoints);
+	columns.time_s.resize(nPoints);
+	columns.elevationDiff_m.resize(nPoints);
+	columns.cumulativeElevation_m.resize(nPoints);
+
+	// Steps between consecutive points
+	// Each step is independent, so these loops can be vectorised
+	calculateStepDistances(gpxData.data(), nPoints, columns.distance_m.data());
+
+	// The other steps are as DistTimeElev::fromGpx
+	double *const time_s = columns.time_s.data();
+	double *const elevationDiff_m = columns.elevationDiff_m.data();
+	double *const cumulativeElevation_m = columns.cumulativeElevation_m.data();
+	time_s[0] = 0.0;
+	elevationDiff_m[0] = 0.0;
+	cumulativeElevation_m[0] = 0.0;
+	for (size_t i = 1; i < nPoints; ++i)
+	{
+		const auto &from = gpxData[i - 1];
+		const auto &to = gpxData[i];
+		time_s[i] = static_cast<double>(to.dateTime_ms - from.dateTime_ms) / 1000.0;
+		elevationDiff_m[i] = to.elevation_m - from.elevation_m;
+		cumulativeElevation_m[i] = std::abs(elevationDiff_m[i]);
+	}
+
+	// Running totals, in place
+	// Summed in order so the totals are identical to adding each step in turn
+	for (auto *column : { &columns.distance_m, &columns.time_s, &columns.elevationDiff_m, &columns.cumulativeElevation_m })
+	{
+		std::partial_sum(column->begin(), column->end(), column->begin());
+	}
+
+	return columns;
+}
+
+void ActivityColumns::append(const DistTimeElev &step)
+{
+	if (empty())
+	{
+		distance_m.push_back(0.0);
+		time_s.push_back(0.0);
+		elevationDiff_m.push_back(0.0);
+		cumulativeElevation_m.push_back(0.0);
+		return;
+	}
+
+	distance_m.push_back(distance_m.back() + step.distanceTime.distance_m);
+	time_s.push_back(time_s.back() + step.distanceTime.time_s);
+	elevationDiff_m.push_back(elevationDiff_m.back() + step.elevation.elevationDiff_m);
+	cumulativeElevation_m.push_back(cumulativeElevation_m.back() + step.elevation.cumulativeElevation_m);
+}
+
+void ActivityColumns::reserve(size_t nPoints)
+{
+	distance_m.reserve(nPoints);
+	time_s.reserve(nPoints);
+	elevationDiff_m.reserve(nPoints);
+	cumulativeElevation_m.reserve(nPoints);
+}
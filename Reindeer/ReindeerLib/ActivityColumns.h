@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "ActivityStructures.h"
+#include "AlignedVector.h"
+
+namespace reindeer
+{
+	// Structure of arrays view of an activity, built once from its gpx points
+	// Each column holds the running total from the first point, so index i is the sum over the gpx steps before point i
+	// Any sub-segment is then the difference of two entries - O(1) rather than re-summing its steps
+	struct ActivityColumns
+	{
+		AlignedVector<double> distance_m;
+		AlignedVector<double> time_s;
+		AlignedVector<double> elevationDiff_m;
+		AlignedVector<double> cumulativeElevation_m;
+
+		static ActivityColumns fromGpx(const std::vector<GpxPoint> &gpxData);
+
+		size_t size() const
+		{
+			return distance_m.size();
+		}
+
+		bool empty() const
+		{
+			return distance_m.empty();
+		}
+
+		DistTimeElev segment(size_t from, size_t to) const
+		{
+			return DistTimeElev(
+				DistanceTime(distance_m[to] - distance_m[from], time_s[to] - time_s[from]),
+				ElevationInfo(elevationDiff_m[to] - elevationDiff_m[from],
+					cumulativeElevation_m[to] - cumulativeElevation_m[from]));
+		}
+
+		DistTimeElev total() const
+		{
+			if (empty())
+				return DistTimeElev::zero();
+
+			return segment(0, size() - 1);
+		}
+
+		// Add the next point, given the step from the previous point (ignored for the first point)
+		void append(const DistTimeElev &step);
+
+		void reserve(size_t nPoints);
+	};
+}
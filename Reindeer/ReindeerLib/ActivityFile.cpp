@@ -0,0 +1,285 @@
+#include "ActivityFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "MemoryMappedFile.h"
+
+using namespace reindeer;
+
+namespace
+{
+	// File layout: FileHeader, then the longitude, latitude, elevation and dateTime columns
+	constexpr uint64_t ACTIVITY_FILE_MAGIC = 0x5443414E49455244; // "DREINACT"
+	constexpr uint64_t ACTIVITY_FILE_VERSION = 1;
+
+	constexpr double UNITS_PER_DEGREE = 1e7;
+	constexpr double UNITS_PER_METRE = 1e2;
+
+	enum Column { LONGITUDE, LATITUDE, ELEVATION, DATE_TIME, N_COLUMNS };
+
+	struct FileHeader
+	{
+		uint64_t magic;
+		uint64_t version;
+		uint64_t nPoints;
+		double minLongitude;
+		double maxLongitude;
+		double minLatitude;
+		double maxLatitude;
+		uint64_t columnSizes_bytes[N_COLUMNS];
+	};
+
+	// Signed deltas are zigzag encoded (0, -1, 1, -2, ...) so that small magnitudes give short varints
+	uint64_t zigzag(int64_t value)
+	{
+		return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+	}
+
+	int64_t unzigzag(uint64_t value)
+	{
+		return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+	}
+
+	void appendVarint(std::vector<char> &out, uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<char>(value));
+	}
+
+	uint64_t readVarint(const unsigned char *&p, const unsigned char *end)
+	{
+		uint64_t value = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7)
+		{
+			if (p == end)
+				throw std::runtime_error("Activity column is truncated");
+
+			const auto byte = *p++;
+			value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if (byte < 0x80)
+				return value;
+		}
+
+		throw std::runtime_error("Invalid varint in activity column");
+	}
+
+	int64_t quantize(double value, double unitsPerValue)
+	{
+		const auto units = value * unitsPerValue;
+		// Leave room for deltas between any two values
+		if (!(std::abs(units) < 1e18))
+			throw std::invalid_argument("Activity value is not finite or is out of range");
+
+		return std::llround(units);
+	}
+
+	// Reads the columns of delta encoded values, in step with each other
+	class ColumnDecoder
+	{
+	public:
+		ColumnDecoder(const unsigned char *begin, const unsigned char *end) :
+			p(begin), end(end)
+		{
+
+		}
+
+		int64_t next()
+		{
+			// Wraps rather than overflowing on corrupt data
+			value += static_cast<uint64_t>(unzigzag(readVarint(p, end)));
+			return static_cast<int64_t>(value);
+		}
+
+		bool atEnd() const
+		{
+			return p == end;
+		}
+
+	private:
+		const unsigned char *p;
+		const unsigned char *const end;
+		uint64_t value = 0;
+	};
+
+	FileHeader readHeader(const char *data, size_t size)
+	{
+		if (size < sizeof(FileHeader))
+			throw std::runtime_error("Activity data is too small for its header");
+
+		FileHeader header;
+		std::memcpy(&header, data, sizeof(header));
+		if (header.magic != ACTIVITY_FILE_MAGIC || header.version != ACTIVITY_FILE_VERSION)
+			throw std::runtime_error("Not an activity file, or an unsupported version");
+
+		// Every point takes at least one byte in each column
+		auto columnsSize_bytes = uint64_t(0);
+		for (const auto columnSize_bytes : header.columnSizes_bytes)
+		{
+			if (columnSize_bytes < header.nPoints || columnSize_bytes > size)
+				throw std::runtime_error("Invalid activity column size");
+
+			columnsSize_bytes += columnSize_bytes;
+		}
+
+		if (columnsSize_bytes != size - sizeof(FileHeader))
+			throw std::runtime_error("Activity data size doesn't match its header");
+
+		return header;
+	}
+
+	ActivitySummary toSummary(const FileHeader &header)
+	{
+		ActivitySummary summary;
+		summary.nPoints = header.nPoints;
+		summary.minLongitude = header.minLongitude;
+		summary.maxLongitude = header.maxLongitude;
+		summary.minLatitude = header.minLatitude;
+		summary.maxLatitude = header.maxLatitude;
+		return summary;
+	}
+}
+
+namespace reindeer
+{
+	std::vector<char> encodeActivity(const std::vector<GpxPoint> &gpxData)
+	{
+		std::vector<char> columns[N_COLUMNS];
+		for (auto &column : columns)
+			column.reserve(2 * gpxData.size());
+
+		int64_t previous[N_COLUMNS] = {};
+		const auto appendDelta = [&columns, &previous](Column column, int64_t value)
+		{
+			appendVarint(columns[column], zigzag(value - previous[column]));
+			previous[column] = value;
+		};
+
+		for (const auto &p : gpxData)
+		{
+			if (p.dateTime_ms > static_cast<uint64_t>(INT64_MAX / 2))
+				throw std::invalid_argument("Activity time is out of range");
+
+			appendDelta(LONGITUDE, quantize(p.longitude, UNITS_PER_DEGREE));
+			appendDelta(LATITUDE, quantize(p.latitude, UNITS_PER_DEGREE));
+			appendDelta(ELEVATION, quantize(p.elevation_m, UNITS_PER_METRE));
+			appendDelta(DATE_TIME, static_cast<int64_t>(p.dateTime_ms));
+		}
+
+		FileHeader header = {};
+		header.magic = ACTIVITY_FILE_MAGIC;
+		header.version = ACTIVITY_FILE_VERSION;
+		header.nPoints = gpxData.size();
+
+		// The bounding box of the values as they will be decoded
+		if (!gpxData.empty())
+		{
+			const auto quantized = [](double value)
+			{
+				return static_cast<double>(quantize(value, UNITS_PER_DEGREE)) / UNITS_PER_DEGREE;
+			};
+
+			const auto longitudes = std::minmax_element(gpxData.begin(), gpxData.end(),
+				[](const auto &a, const auto &b) { return a.longitude < b.longitude; });
+			const auto latitudes = std::minmax_element(gpxData.begin(), gpxData.end(),
+				[](const auto &a, const auto &b) { return a.latitude < b.latitude; });
+
+			header.minLongitude = quantized(longitudes.first->longitude);
+			header.maxLongitude = quantized(longitudes.second->longitude);
+			header.minLatitude = quantized(latitudes.first->latitude);
+			header.maxLatitude = quantized(latitudes.second->latitude);
+		}
+
+		auto size_bytes = sizeof(FileHeader);
+		for (int column = 0; column < N_COLUMNS; ++column)
+		{
+			header.columnSizes_bytes[column] = columns[column].size();
+			size_bytes += columns[column].size();
+		}
+
+		std::vector<char> data;
+		data.reserve(size_bytes);
+		data.insert(data.end(), reinterpret_cast<const char *>(&header), reinterpret_cast<const char *>(&header + 1));
+		for (const auto &column : columns)
+			data.insert(data.end(), column.begin(), column.end());
+
+		return data;
+	}
+
+	ActivitySummary decodeActivitySummary(const char *data, size_t size)
+	{
+		return toSummary(readHeader(data, size));
+	}
+
+	std::vector<GpxPoint> decodeActivity(const char *data, size_t size)
+	{
+		const auto header = readHeader(data, size);
+
+		std::vector<ColumnDecoder> decoders;
+		decoders.reserve(N_COLUMNS);
+		auto columnBegin = reinterpret_cast<const unsigned char *>(data) + sizeof(FileHeader);
+		for (const auto columnSize_bytes : header.columnSizes_bytes)
+		{
+			decoders.emplace_back(columnBegin, columnBegin + columnSize_bytes);
+			columnBegin += columnSize_bytes;
+		}
+
+		auto &longitudes = decoders[LONGITUDE];
+		auto &latitudes = decoders[LATITUDE];
+		auto &elevations = decoders[ELEVATION];
+		auto &dateTimes = decoders[DATE_TIME];
+
+		// Dividing (rather than multiplying by the reciprocal) gives back exactly the double nearest the decimal value
+		std::vector<GpxPoint> gpxData;
+		gpxData.reserve(header.nPoints);
+		for (uint64_t i = 0; i < header.nPoints; ++i)
+		{
+			const auto longitude = static_cast<double>(longitudes.next()) / UNITS_PER_DEGREE;
+			const auto latitude = static_cast<double>(latitudes.next()) / UNITS_PER_DEGREE;
+			const auto elevation_m = static_cast<double>(elevations.next()) / UNITS_PER_METRE;
+			const auto dateTime_ms = static_cast<uint64_t>(dateTimes.next());
+			gpxData.emplace_back(longitude, latitude, elevation_m, dateTime_ms);
+		}
+
+		for (const auto &decoder : decoders)
+		{
+			if (!decoder.atEnd())
+				throw std::runtime_error("Activity column has trailing data");
+		}
+
+		return gpxData;
+	}
+
+	void writeActivityFile(const std::wstring &path, const std::vector<GpxPoint> &gpxData)
+	{
+		const auto data = encodeActivity(gpxData);
+
+		std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("Failed to open activity file for writing");
+
+		out.write(data.data(), data.size());
+		if (!out)
+			throw std::runtime_error("Failed to write activity file");
+	}
+
+	ActivitySummary readActivitySummary(const std::wstring &path)
+	{
+		const MemoryMappedFile file(path);
+		return decodeActivitySummary(file.data(), file.size());
+	}
+
+	std::vector<GpxPoint> readActivityFile(const std::wstring &path)
+	{
+		const MemoryMappedFile file(path);
+		return decodeActivity(file.data(), file.size());
+	}
+}
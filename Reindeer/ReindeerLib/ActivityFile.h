@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ActivityStructures.h"
+
+namespace reindeer
+{
+	// Compact binary activity format, roughly 10x smaller than GPX and much faster to load
+	// Each GpxPoint field is stored as its own column of zigzag varint deltas:
+	// longitude and latitude in 1e-7 degrees, elevation in cm and dateTime in ms
+	// Values with at most that many decimal places (as GPX files usually have) are stored exactly
+
+	struct ActivitySummary
+	{
+		uint64_t nPoints = 0;
+
+		// Bounding box of the stored points (all zero if there are none)
+		double minLongitude = 0.0;
+		double maxLongitude = 0.0;
+		double minLatitude = 0.0;
+		double maxLatitude = 0.0;
+	};
+
+	// Throws std::invalid_argument if a value is not finite or is out of range
+	std::vector<char> encodeActivity(const std::vector<GpxPoint> &gpxData);
+
+	// Throws std::runtime_error if the data isn't a valid activity
+	ActivitySummary decodeActivitySummary(const char *data, size_t size);
+	std::vector<GpxPoint> decodeActivity(const char *data, size_t size);
+
+	// Throws std::runtime_error if the file can't be written
+	void writeActivityFile(const std::wstring &path, const std::vector<GpxPoint> &gpxData);
+
+	// Memory map the file and decode it (only the header for the summary)
+	// Throws std::runtime_error if the file can't be read or isn't a valid activity
+	ActivitySummary readActivitySummary(const std::wstring &path);
+	std::vector<GpxPoint> readActivityFile(const std::wstring &path);
+}
@@ -0,0 +1,224 @@
+#include "ActivityIngest.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <stdexcept>
+
+#include "ActivityColumns.h"
+#include "BoundedQueue.h"
+#include "GpxParser.h"
+#include "ParallelHelpers.h"
+
+using namespace reindeer;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct ReadFile
+	{
+		size_t index;
+		std::vector<char> data;
+	};
+
+	struct ParsedFile
+	{
+		size_t index;
+		std::vector<GpxPoint> gpxData;
+	};
+
+	// nullptr tells a consumer that the previous stage has finished
+	using ReadQueue = BoundedQueue<std::unique_ptr<ReadFile>>;
+	using ParsedQueue = BoundedQueue<std::unique_ptr<ParsedFile>>;
+
+	std::vector<char> readWholeFile(const std::wstring &path)
+	{
+		std::ifstream file(std::filesystem::path(path), std::ios::binary | std::ios::ate);
+		if (!file)
+			throw std::runtime_error("Failed to open file");
+
+		std::vector<char> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(data.data(), data.size());
+		if (!file)
+			throw std::runtime_error("Failed to read file");
+
+		return data;
+	}
+
+	double secondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	// Each thread keeps its own totals, which are summed once the stage has finished
+	struct StageCounters
+	{
+		size_t nFiles = 0;
+		uint64_t nBytes = 0;
+		uint64_t nPoints = 0;
+		double busyTime_s = 0.0;
+	};
+
+	IngestStageStats sumCounters(const std::vector<StageCounters> &counters)
+	{
+		IngestStageStats stats;
+		stats.nThreads = static_cast<unsigned>(counters.size());
+		for (const auto &c : counters)
+		{
+			stats.nFiles += c.nFiles;
+			stats.nBytes += c.nBytes;
+			stats.nPoints += c.nPoints;
+			stats.busyTime_s += c.busyTime_s;
+		}
+
+		return stats;
+	}
+
+	// Runs fn(threadIndex) on nThreads threads, and then finished() once on the last thread to finish
+	template <typename Fn, typename FinishedFn>
+	std::vector<std::future<void>> launchStage(unsigned nThreads, Fn fn, FinishedFn finished)
+	{
+		const auto nRunning = std::make_shared<std::atomic<unsigned>>(nThreads);
+
+		std::vector<std::future<void>> threads;
+		for (unsigned t = 0; t < nThreads; ++t)
+		{
+			threads.push_back(std::async(std::launch::async, [t, nRunning, fn, finished]()
+			{
+				fn(t);
+				if (--*nRunning == 0)
+					finished();
+			}));
+		}
+
+		return threads;
+	}
+}
+
+namespace reindeer
+{
+	std::vector<IngestedActivity> ingestActivities(
+		const std::vector<std::wstring> &paths,
+		const IngestOptions &options,
+		IngestStats *stats)
+	{
+		const auto start = Clock::now();
+
+		std::vector<IngestedActivity> activities(paths.size());
+		for (size_t i = 0; i < paths.size(); ++i)
+			activities[i].path = paths[i];
+
+		const auto nReadThreads = resolveThreadCount(options.nReadThreads);
+		const auto nParseThreads = resolveThreadCount(options.nParseThreads);
+		const auto nAnalysisThreads = resolveThreadCount(options.nAnalysisThreads);
+
+		ReadQueue readQueue(options.queueCapacity);
+		ParsedQueue parsedQueue(options.queueCapacity);
+
+		std::vector<StageCounters> readCounters(nReadThreads);
+		std::vector<StageCounters> parseCounters(nParseThreads);
+		std::vector<StageCounters> analysisCounters(nAnalysisThreads);
+
+		// An exception escaping a stage would leave the other stages waiting, so failures are recorded against their file instead
+		std::atomic<size_t> nextPath{ 0 };
+		auto readThreads = launchStage(nReadThreads, [&](unsigned t)
+		{
+			auto &counters = readCounters[t];
+			for (auto i = nextPath++; i < paths.size(); i = nextPath++)
+			{
+				const auto fileStart = Clock::now();
+				try
+				{
+					auto readFile = std::make_unique<ReadFile>(ReadFile{ i, readWholeFile(paths[i]) });
+					++counters.nFiles;
+					counters.nBytes += readFile->data.size();
+					counters.busyTime_s += secondsSince(fileStart);
+					readQueue.waitForPush(std::move(readFile));
+				}
+				catch (const std::exception &e)
+				{
+					activities[i].error = e.what();
+					counters.busyTime_s += secondsSince(fileStart);
+				}
+			}
+		}, [&]()
+		{
+			for (unsigned t = 0; t < nParseThreads; ++t)
+				readQueue.waitForPush(nullptr);
+		});
+
+		auto parseThreads = launchStage(nParseThreads, [&](unsigned t)
+		{
+			auto &counters = parseCounters[t];
+			while (const auto readFile = readQueue.waitForPop())
+			{
+				const auto fileStart = Clock::now();
+				try
+				{
+					auto parsedFile = std::make_unique<ParsedFile>(
+						ParsedFile{ readFile->index, parseGpx(readFile->data.data(), readFile->data.size()) });
+					++counters.nFiles;
+					counters.nBytes += readFile->data.size();
+					counters.nPoints += parsedFile->gpxData.size();
+					counters.busyTime_s += secondsSince(fileStart);
+					parsedQueue.waitForPush(std::move(parsedFile));
+				}
+				catch (const std::exception &e)
+				{
+					activities[readFile->index].error = e.what();
+					counters.busyTime_s += secondsSince(fileStart);
+				}
+			}
+		}, [&]()
+		{
+			for (unsigned t = 0; t < nAnalysisThreads; ++t)
+				parsedQueue.waitForPush(nullptr);
+		});
+
+		// Each activity's pace curve is single threaded, as the analysis threads already work on different files
+		auto analysisThreads = launchStage(nAnalysisThreads, [&](unsigned t)
+		{
+			auto &counters = analysisCounters[t];
+			while (const auto parsedFile = parsedQueue.waitForPop())
+			{
+				const auto fileStart = Clock::now();
+				auto &activity = activities[parsedFile->index];
+				try
+				{
+					const auto columns = ActivityColumns::fromGpx(parsedFile->gpxData);
+					activity.paceCurve = calculatePaceCurve(columns,
+						options.min_m, options.resolution_m, options.minElevationDiff_m);
+					activity.nPoints = parsedFile->gpxData.size();
+					++counters.nFiles;
+					counters.nPoints += parsedFile->gpxData.size();
+				}
+				catch (const std::exception &e)
+				{
+					activity.error = e.what();
+				}
+				counters.busyTime_s += secondsSince(fileStart);
+			}
+		}, []() {});
+
+		for (auto *threads : { &readThreads, &parseThreads, &analysisThreads })
+		{
+			for (auto &thread : *threads)
+				thread.get();
+		}
+
+		if (stats)
+		{
+			stats->read = sumCounters(readCounters);
+			stats->parse = sumCounters(parseCounters);
+			stats->analysis = sumCounters(analysisCounters);
+			stats->elapsed_s = secondsSince(start);
+		}
+
+		return activities;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "PaceCurve.h"
+
+namespace reindeer
+{
+	struct IngestOptions
+	{
+		// Threads for each stage (0 uses all hardware threads)
+		unsigned nReadThreads = 2;
+		unsigned nParseThreads = 0;
+		unsigned nAnalysisThreads = 0;
+
+		// Files waiting between stages, beyond which the earlier stage waits
+		size_t queueCapacity = 8;
+
+		// Pace curve parameters, as for calculatePaceCurve
+		double min_m = 100.0;
+		double resolution_m = 100.0;
+		double minElevationDiff_m = -1e9;
+	};
+
+	struct IngestedActivity
+	{
+		std::wstring path;
+		size_t nPoints = 0;
+		std::vector<PaceCurvePoint> paceCurve;
+
+		// Empty unless the file couldn't be read, parsed or analysed
+		std::string error;
+	};
+
+	struct IngestStageStats
+	{
+		unsigned nThreads = 0;
+		size_t nFiles = 0;
+		uint64_t nBytes = 0;
+		uint64_t nPoints = 0;
+
+		// Summed over the stage's threads, excluding time spent waiting on the queues
+		double busyTime_s = 0.0;
+
+		// Fraction of the stage's thread time spent working - the stage nearest 1 is the bottleneck
+		double utilisation(double elapsed_s) const
+		{
+			return elapsed_s > 0.0 ? busyTime_s / (nThreads * elapsed_s) : 0.0;
+		}
+	};
+
+	struct IngestStats
+	{
+		IngestStageStats read;
+		IngestStageStats parse;
+		IngestStageStats analysis;
+		double elapsed_s = 0.0;
+	};
+
+	// Reads, parses (GPX) and calculates the pace curve of every file, with each stage on its own threads
+	// Bounded queues between the stages limit the files held in memory to roughly the queue capacities plus the thread counts
+	// Returns the activities in the same order as the paths - a file that fails reports its error rather than stopping the others
+	std::vector<IngestedActivity> ingestActivities(
+		const std::vector<std::wstring> &paths,
+		const IngestOptions &options,
+		IngestStats *stats = nullptr);
+}
@@ -0,0 +1,296 @@
+#include "ActivitySpatialIndex.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+
+#include "Octree.h"
+
+#include "MemoryMappedFile.h"
+
+using namespace reindeer;
+
+namespace
+{
+	// File layout: FileHeader, IndexKey[nKeys], then ActivityPointRef[nRefs]
+	constexpr uint64_t INDEX_FILE_MAGIC = 0x5844494E49455244; // "DREINIDX"
+	constexpr uint64_t INDEX_FILE_VERSION = 1;
+
+	struct FileHeader
+	{
+		uint64_t magic;
+		uint64_t version;
+		uint64_t nKeys;
+		uint64_t nRefs;
+	};
+
+	// The points at one position, as a range of the index's refs
+	struct IndexKey
+	{
+		obelisk::Vector3f pos;
+		uint32_t firstRef;
+		uint32_t nRefs;
+	};
+
+	struct GetKeyPos
+	{
+		static const obelisk::Vector3f &getPos(const IndexKey &key)
+		{
+			return key.pos;
+		}
+	};
+
+	using KeyOctree = obelisk::Octree<IndexKey, 256, GetKeyPos>;
+
+	obelisk::Vector3f toPos(const GpxPoint &p)
+	{
+		return obelisk::Vector3f(static_cast<float>(p.longitude), static_cast<float>(p.latitude), static_cast<float>(p.elevation_m));
+	}
+
+	obelisk::Box toBox(double minLongitude, double minLatitude, double maxLongitude, double maxLatitude,
+		double minElevation_m, double maxElevation_m)
+	{
+		const auto toFloat = [](double value)
+		{
+			return static_cast<float>(std::max<double>(-FLT_MAX, std::min<double>(FLT_MAX, value)));
+		};
+
+		return obelisk::Box(
+			obelisk::Vector3f(toFloat(minLongitude), toFloat(minLatitude), toFloat(minElevation_m)),
+			obelisk::Vector3f(toFloat(maxLongitude), toFloat(maxLatitude), toFloat(maxElevation_m)));
+	}
+
+	void sortRefs(std::vector<ActivityPointRef> &refs)
+	{
+		std::sort(refs.begin(), refs.end(), [](const auto &a, const auto &b)
+		{
+			return std::tie(a.activityId, a.pointIndex) < std::tie(b.activityId, b.pointIndex);
+		});
+	}
+
+	std::vector<uint32_t> toActivityIds(const std::vector<ActivityPointRef> &refs)
+	{
+		std::vector<uint32_t> activityIds;
+		for (const auto &ref : refs)
+		{
+			if (activityIds.empty() || activityIds.back() != ref.activityId)
+				activityIds.push_back(ref.activityId);
+		}
+
+		return activityIds;
+	}
+}
+
+struct ActivitySpatialIndex::Impl
+{
+	// Refs grouped by key, so that each octree item is a unique position
+	// (the octree splits a node holding too many items, which never ends if they share a position)
+	std::vector<ActivityPointRef> refs;
+	std::unique_ptr<KeyOctree> octree;
+
+	explicit Impl(const std::vector<std::vector<GpxPoint>> &activities)
+	{
+		size_t nPoints = 0;
+		for (const auto &gpxData : activities)
+			nPoints += gpxData.size();
+
+		if (activities.size() > std::numeric_limits<uint32_t>::max() ||
+			nPoints > std::numeric_limits<uint32_t>::max())
+			throw std::invalid_argument("Too many points for an activity spatial index");
+
+		std::vector<std::pair<obelisk::Vector3f, ActivityPointRef>> entries;
+		entries.reserve(nPoints);
+		for (size_t a = 0; a < activities.size(); ++a)
+		{
+			for (size_t i = 0; i < activities[a].size(); ++i)
+				entries.emplace_back(toPos(activities[a][i]), ActivityPointRef{ static_cast<uint32_t>(a), static_cast<uint32_t>(i) });
+		}
+
+		// Entries are already in ref order, so a stable sort keeps each key's refs ordered
+		std::stable_sort(entries.begin(), entries.end(), [](const auto &a, const auto &b)
+		{
+			return a.first < b.first;
+		});
+
+		std::vector<IndexKey> keys;
+		refs.reserve(nPoints);
+		for (const auto &entry : entries)
+		{
+			if (keys.empty() || keys.back().pos != entry.first)
+				keys.push_back(IndexKey{ entry.first, static_cast<uint32_t>(refs.size()), 0 });
+
+			refs.push_back(entry.second);
+			++keys.back().nRefs;
+		}
+
+		buildOctree(keys);
+	}
+
+	explicit Impl(const std::wstring &path)
+	{
+		const MemoryMappedFile file(path);
+		const auto data = file.data();
+		const auto size = file.size();
+
+		FileHeader header;
+		if (size < sizeof(header))
+			throw std::runtime_error("Activity spatial index file is too small for its header");
+
+		std::memcpy(&header, data, sizeof(header));
+		if (header.magic != INDEX_FILE_MAGIC || header.version != INDEX_FILE_VERSION ||
+			header.nKeys > size / sizeof(IndexKey) || header.nRefs > size / sizeof(ActivityPointRef) ||
+			sizeof(header) + header.nKeys * sizeof(IndexKey) + header.nRefs * sizeof(ActivityPointRef) != size)
+			throw std::runtime_error("Not an activity spatial index file, or an unsupported version");
+
+		std::vector<IndexKey> keys(header.nKeys);
+		refs.resize(header.nRefs);
+		std::memcpy(keys.data(), data + sizeof(header), keys.size() * sizeof(IndexKey));
+		std::memcpy(refs.data(), data + sizeof(header) + keys.size() * sizeof(IndexKey), refs.size() * sizeof(ActivityPointRef));
+
+		// Keys are saved in position order, and must be unique to go in the octree
+		for (size_t k = 0; k < keys.size(); ++k)
+		{
+			const auto &key = keys[k];
+			if (key.nRefs == 0 || key.firstRef > refs.size() || key.nRefs > refs.size() - key.firstRef ||
+				(k > 0 && !(keys[k - 1].pos < key.pos)))
+				throw std::runtime_error("Invalid key in activity spatial index file");
+		}
+
+		buildOctree(keys);
+	}
+
+	void buildOctree(const std::vector<IndexKey> &keys)
+	{
+		auto extents = obelisk::Box(obelisk::Vector3f(), obelisk::Vector3f());
+		if (!keys.empty())
+		{
+			extents = obelisk::Box(keys.front().pos, keys.front().pos);
+			for (const auto &key : keys)
+			{
+				extents.min = obelisk::Vector3f(std::min(extents.min.x, key.pos.x), std::min(extents.min.y, key.pos.y), std::min(extents.min.z, key.pos.z));
+				extents.max = obelisk::Vector3f(std::max(extents.max.x, key.pos.x), std::max(extents.max.y, key.pos.y), std::max(extents.max.z, key.pos.z));
+			}
+		}
+
+		octree = std::make_unique<KeyOctree>(extents);
+		octree->insertRange(keys);
+	}
+
+	template <typename Fn>
+	std::vector<ActivityPointRef> findPoints(const obelisk::Box &box, Fn isIncluded) const
+	{
+		std::vector<ActivityPointRef> found;
+		octree->forEachItemInBox(box, [this, &found, &isIncluded](const IndexKey &key)
+		{
+			if (isIncluded(key.pos))
+				found.insert(found.end(), refs.begin() + key.firstRef, refs.begin() + key.firstRef + key.nRefs);
+		});
+
+		sortRefs(found);
+		return found;
+	}
+
+	std::vector<ActivityPointRef> findPointsInBox(const obelisk::Box &box) const
+	{
+		return findPoints(box, [](const obelisk::Vector3f &) { return true; });
+	}
+
+	std::vector<ActivityPointRef> findPointsNear(double longitude, double latitude, double radius_m) const
+	{
+		// Any point within radius_m is within this longitude/latitude box
+		const auto radius_deg = radius_m / (EARTH_RADIUS_m * RADIANS_PER_DEGREE);
+		const auto latitude_rad = latitude * RADIANS_PER_DEGREE;
+		const auto cosLatitude = std::cos(latitude_rad);
+		const auto furthestLatitude_deg = std::min(90.0, std::abs(latitude) + radius_deg);
+		const auto minCosLatitude = std::cos(furthestLatitude_deg * RADIANS_PER_DEGREE);
+
+		// Longitude differences count for cosLatitude * cos(point latitude) of their size
+		const auto longitudeScale = std::sqrt(std::max(0.0, cosLatitude * minCosLatitude));
+		const auto longitudeRadius_deg = longitudeScale * 360.0 > radius_deg ? radius_deg / longitudeScale : 360.0;
+
+		const auto box = toBox(longitude - longitudeRadius_deg, latitude - radius_deg,
+			longitude + longitudeRadius_deg, latitude + radius_deg, -FLT_MAX, FLT_MAX);
+
+		const auto longitude_rad = longitude * RADIANS_PER_DEGREE;
+		return findPoints(box, [=](const obelisk::Vector3f &pos)
+		{
+			const auto pointLatitude_rad = pos.y * RADIANS_PER_DEGREE;
+			return equirectangularDistance_m(latitude_rad, longitude_rad, cosLatitude,
+				pointLatitude_rad, pos.x * RADIANS_PER_DEGREE, std::cos(pointLatitude_rad)) <= radius_m;
+		});
+	}
+
+	void save(const std::wstring &path) const
+	{
+		std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::runtime_error("Failed to open activity spatial index file for writing");
+
+		std::vector<IndexKey> keys;
+		keys.reserve(octree->getTotalItemCount());
+		octree->forEachItem([&keys](const IndexKey &key) { keys.push_back(key); });
+		std::sort(keys.begin(), keys.end(), [](const auto &a, const auto &b) { return a.pos < b.pos; });
+
+		const FileHeader header = { INDEX_FILE_MAGIC, INDEX_FILE_VERSION, keys.size(), refs.size() };
+		out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char *>(keys.data()), keys.size() * sizeof(IndexKey));
+		out.write(reinterpret_cast<const char *>(refs.data()), refs.size() * sizeof(ActivityPointRef));
+
+		if (!out)
+			throw std::runtime_error("Failed to write activity spatial index file");
+	}
+};
+
+ActivitySpatialIndex::ActivitySpatialIndex(const std::vector<std::vector<GpxPoint>> &activities) :
+	impl(std::make_unique<Impl>(activities))
+{
+}
+
+ActivitySpatialIndex::ActivitySpatialIndex(const std::wstring &path) :
+	impl(std::make_unique<Impl>(path))
+{
+}
+
+ActivitySpatialIndex::~ActivitySpatialIndex()
+{
+}
+
+void ActivitySpatialIndex::save(const std::wstring &path) const
+{
+	impl->save(path);
+}
+
+size_t ActivitySpatialIndex::pointCount() const
+{
+	return impl->refs.size();
+}
+
+std::vector<ActivityPointRef> ActivitySpatialIndex::findPointsInBox(
+	double minLongitude, double minLatitude, double maxLongitude, double maxLatitude,
+	double minElevation_m, double maxElevation_m) const
+{
+	return impl->findPointsInBox(toBox(minLongitude, minLatitude, maxLongitude, maxLatitude, minElevation_m, maxElevation_m));
+}
+
+std::vector<ActivityPointRef> ActivitySpatialIndex::findPointsNear(double longitude, double latitude, double radius_m) const
+{
+	return impl->findPointsNear(longitude, latitude, radius_m);
+}
+
+std::vector<uint32_t> ActivitySpatialIndex::findActivitiesInBox(
+	double minLongitude, double minLatitude, double maxLongitude, double maxLatitude,
+	double minElevation_m, double maxElevation_m) const
+{
+	return toActivityIds(findPointsInBox(minLongitude, minLatitude, maxLongitude, maxLatitude, minElevation_m, maxElevation_m));
+}
+
+std::vector<uint32_t> ActivitySpatialIndex::findActivitiesNear(double longitude, double latitude, double radius_m) const
+{
+	return toActivityIds(findPointsNear(longitude, latitude, radius_m));
+}
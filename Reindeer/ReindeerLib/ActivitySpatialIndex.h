@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ActivityStructures.h"
+
+namespace reindeer
+{
+	struct ActivityPointRef
+	{
+		uint32_t activityId;
+		uint32_t pointIndex;
+	};
+
+	// Spatial index over the points of many activities, for finding the activities that pass through a region
+	// Points are keyed on longitude, latitude and elevation in an obelisk::Octree, at float precision (within a metre or so)
+	// Points sharing a key (e.g. while stopped) share one octree item
+	// Built in one go - adding activities means building a new index
+	class ActivitySpatialIndex
+	{
+	public:
+		// The activity ids are the indices into activities
+		explicit ActivitySpatialIndex(const std::vector<std::vector<GpxPoint>> &activities);
+
+		// Loads an index written by save()
+		// Throws std::runtime_error if the file can't be read or isn't a valid index
+		explicit ActivitySpatialIndex(const std::wstring &path);
+
+		~ActivitySpatialIndex();
+
+		ActivitySpatialIndex(const ActivitySpatialIndex &) = delete;
+		ActivitySpatialIndex &operator=(const ActivitySpatialIndex &) = delete;
+
+		// Throws std::runtime_error if the file can't be written
+		void save(const std::wstring &path) const;
+
+		size_t pointCount() const;
+
+		// Points within the box (inclusive), ordered by activity id then point index
+		std::vector<ActivityPointRef> findPointsInBox(
+			double minLongitude, double minLatitude, double maxLongitude, double maxLatitude,
+			double minElevation_m = -1e9, double maxElevation_m = 1e9) const;
+
+		// Points within radius_m of the location, ignoring elevation, ordered by activity id then point index
+		// The search doesn't wrap across +-180 degrees longitude
+		std::vector<ActivityPointRef> findPointsNear(double longitude, double latitude, double radius_m) const;
+
+		// Distinct activity ids of the points in the box or near the location, in increasing order
+		std::vector<uint32_t> findActivitiesInBox(
+			double minLongitude, double minLatitude, double maxLongitude, double maxLatitude,
+			double minElevation_m = -1e9, double maxElevation_m = 1e9) const;
+		std::vector<uint32_t> findActivitiesNear(double longitude, double latitude, double radius_m) const;
+
+	private:
+		struct Impl;
+		const std::unique_ptr<Impl> impl;
+	};
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 
 namespace reindeer
 {
@@ -20,6 +23,25 @@ namespace reindeer
 		GpxPoint() = delete;
 	};
 
+	// Mean radius of the earth
+	constexpr double EARTH_RADIUS_m = 6371008.8;
+	constexpr double PI = 3.14159265358979323846;
+	constexpr double RADIANS_PER_DEGREE = PI / 180.0;
+
+	// Equirectangular approximation of the distance between two nearby points, taking the cosine of each latitude
+	// Within 1e-6 (relative) of the great circle distance for points up to 5km apart below 80 degrees latitude
+	// The error grows towards the poles (3e-6 at 85 degrees)
+	inline double equirectangularDistance_m(
+		double fromLatitude_rad, double fromLongitude_rad, double fromCosLatitude,
+		double toLatitude_rad, double toLongitude_rad, double toCosLatitude)
+	{
+		const auto latDiff = toLatitude_rad - fromLatitude_rad;
+		// Steps across the antimeridian go the short way round, longitudes being within [-pi, pi]
+		const auto absLongDiff = std::abs(toLongitude_rad - fromLongitude_rad);
+		const auto longDiff = std::min(absLongDiff, 2.0 * PI - absLongDiff);
+		return EARTH_RADIUS_m * std::sqrt(latDiff * latDiff + (fromCosLatitude * toCosLatitude) * (longDiff * longDiff));
+	}
+
 	struct DistanceTime
 	{
 		double distance_m;
@@ -89,13 +111,14 @@ namespace reindeer
 
 		static DistTimeElev fromGpx(const GpxPoint &from, const GpxPoint &to)
 		{
-			// Calculate distance from long/lat change
-			// This calculation is currently abitrary
-			const auto longDiff = to.longitude - from.longitude;
-			const auto latDiff = to.latitude - from.latitude;
-			const auto distance_m = sqrt(longDiff*longDiff + latDiff*latDiff);
-
-			const auto time_s = 1000.0 * static_cast<double>(to.dateTime_ms - from.dateTime_ms);
+			// Calculate distance from long/lat change (calculateStepDistances gives identical results over whole tracks)
+			const auto fromLatitude_rad = from.latitude * RADIANS_PER_DEGREE;
+			const auto toLatitude_rad = to.latitude * RADIANS_PER_DEGREE;
+			const auto distance_m = equirectangularDistance_m(
+				fromLatitude_rad, from.longitude * RADIANS_PER_DEGREE, std::cos(fromLatitude_rad),
+				toLatitude_rad, to.longitude * RADIANS_PER_DEGREE, std::cos(toLatitude_rad));
+
+			const auto time_s = static_cast<double>(to.dateTime_ms - from.dateTime_ms) / 1000.0;
 
 			const auto elevGain = to.elevation_m - from.elevation_m;
 
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace reindeer
+{
+	// Allocator returning memory aligned to Alignment bytes (e.g. cache lines or SIMD registers)
+	template <typename T, size_t Alignment>
+	struct AlignedAllocator
+	{
+		static_assert(Alignment >= alignof(T), "Alignment must be at least the alignment of T");
+
+		using value_type = T;
+
+		template <typename U>
+		struct rebind
+		{
+			using other = AlignedAllocator<U, Alignment>;
+		};
+
+		AlignedAllocator() = default;
+
+		template <typename U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment> &)
+		{
+		}
+
+		T *allocate(size_t n)
+		{
+			return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+		}
+
+		void deallocate(T *p, size_t)
+		{
+			::operator delete(p, std::align_val_t(Alignment));
+		}
+
+		template <typename U>
+		bool operator==(const AlignedAllocator<U, Alignment> &) const
+		{
+			return true;
+		}
+
+		template <typename U>
+		bool operator!=(const AlignedAllocator<U, Alignment> &) const
+		{
+			return false;
+		}
+	};
+
+	constexpr size_t CACHE_LINE_SIZE = 64;
+
+	// std::vector with its data aligned to a cache line
+	template <typename T>
+	using AlignedVector = std::vector<T, AlignedAllocator<T, CACHE_LINE_SIZE>>;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ConcurrentQueueT.h"
+
+namespace reindeer
+{
+	// MultipleProducerSingleConsumerQueue that blocks producers while it holds capacity items, so a slow consumer holds back its producers
+	// Pops are made under the queue's lock, so any number of threads may consume
+	// Like obelisk's queues, T must be default constructible (e.g. a std::unique_ptr, with nullptr to tell a consumer to stop)
+	template <typename T>
+	class BoundedQueue : private obelisk::MultipleProducerSingleConsumerQueue<T>
+	{
+	public:
+		explicit BoundedQueue(size_t capacity) :
+			capacity(capacity > 0 ? capacity : 1)
+		{
+
+		}
+
+		using obelisk::MultipleProducerSingleConsumerQueue<T>::size;
+		using obelisk::MultipleProducerSingleConsumerQueue<T>::empty;
+
+		// Waits for space, then adds the item
+		void waitForPush(T &&item)
+		{
+			{
+				obelisk::UniqueLock<obelisk::Mutex> lock(mutex);
+				while (queue.size() >= capacity)
+				{
+					notFull.wait(lock);
+				}
+
+				queue.push_back(std::move(item));
+			}
+
+			condition.notifyOne();
+		}
+
+		T waitForPop()
+		{
+			T item;
+
+			// Scope for lock
+			{
+				obelisk::UniqueLock<obelisk::Mutex> lock(mutex);
+				while (queue.empty())
+				{
+					condition.wait(lock);
+				}
+
+				// Use swap to allow use with move-only types (e.g. unique_ptr)
+				std::swap(queue.front(), item);
+				queue.pop_front();
+			}
+
+			notFull.notifyOne();
+			return item;
+		}
+
+	private:
+		using obelisk::MultipleProducerSingleConsumerQueue<T>::queue;
+		using obelisk::MultipleProducerSingleConsumerQueue<T>::mutex;
+		using obelisk::MultipleProducerSingleConsumerQueue<T>::condition;
+
+		const size_t capacity;
+		obelisk::ConditionVariable notFull;
+	};
+}
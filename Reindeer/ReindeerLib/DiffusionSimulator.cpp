@@ -1,91 +1,338 @@
 #include "DiffusionSimulator.h"
 
-#include "PointGenLib_Rust\PointGenLib.h"
+#include <algorithm>
+
+#include "ParallelHelpers.h"
+#include "PhiloxRandom.h"
 
 using namespace reindeer;
 
-DiffusionSimulator::DiffusionSimulator() = default;
+namespace
+{
+	// Times fn(chunkIndex) over every chunk, across the same threads as the fused pass so the sweeps compare fairly
+	template <typename Fn>
+	std::chrono::nanoseconds timeParallelSweep(const size_t nChunks, const unsigned nThreads, Fn fn)
+	{
+		auto const beforeTime = std::chrono::high_resolution_clock::now();
+		forEachChunkInParallel(nChunks, nThreads, fn);
+		return std::chrono::high_resolution_clock::now() - beforeTime;
+	}
+}
+
+DiffusionSimulator::DiffusionSimulator() :
+	DiffusionSimulator(std::random_device()(), 0)
+{
+}
+
+DiffusionSimulator::DiffusionSimulator(uint32_t masterSeed, unsigned nThreads, DiffusionRandomMode randomMode, PointLayout layout, DiffusionKernel kernel) :
+	masterSeed(masterSeed),
+	nThreads(nThreads),
+	randomMode(randomMode),
+	layout(layout),
+	kernel(kernel),
+	simdLevel(detectSimdLevel())
+{
+	seedRandomStreams();
+}
+
 DiffusionSimulator::~DiffusionSimulator() = default;
 
+void DiffusionSimulator::seedRandomStreams()
+{
+	for (size_t c = 0; c < randomStreams.size(); ++c)
+	{
+		std::seed_seq seed = { masterSeed, static_cast<uint32_t>(c) };
+		randomStreams[c].randomEng.seed(seed);
+		randomStreams[c].randomMovement.reset();
+	}
+}
+
 void DiffusionSimulator::initialise(size_t totalPoints, float width, float height)
 {
-	auto const midPointX = width*0.5;
-	auto const midPointY = height*0.5;
-	data.lockedModify([this, totalPoints, midPointX, midPointY](DataT &data)
+	auto &data = frames.back();
+
+	// Allocate arrays
+	// Distribute the points across the chunks - if not exactly divisible, the last chunk will have less chunk
+	auto const pointsPerChunk = totalPoints == 0 ? size_t(0) : (totalPoints - 1) / nChunks + 1;
+	auto pointsSoFar = decltype(pointsPerChunk){};
+	for (size_t i = 0; i<data.size(); ++i)
+	{
+		auto const pointsThisChunk = std::min(pointsPerChunk, totalPoints - pointsSoFar);
+		data[i].positions.assign(pointsThisChunk, { 0.f,0.f,0.f });
+		pointsSoFar += pointsThisChunk;
+	}
+
+	// Random initial positions, each chunk from its own engine so they only depend on the master seed
+	// The extra seed word keeps them apart from the chunk's movement stream
+	std::uniform_real_distribution<float> randomX(0.f, width);
+	std::uniform_real_distribution<float> randomY(0.f, height);
+	for (size_t c = 0; c < data.size(); ++c)
 	{
-		// Allocate arrays
-		// Distribute the points across the chunks - if not exactly divisible, the last chunk will have less chunk
-		auto const pointsPerChunk = (totalPoints - 1 / nChunks) + 1UL;
-		auto pointsSoFar = decltype(pointsPerChunk){};
-		for (size_t i = 0; i<data.size(); ++i)
+		std::seed_seq seed = { masterSeed, static_cast<uint32_t>(c), 1u };
+		std::mt19937 randomEng(seed);
+		for (auto &p : data[c].positions)
 		{
-			auto const pointsThisChunk = std::min(pointsPerChunk, totalPoints - pointsSoFar);
-			data[i].positions.assign(pointsThisChunk, { 0.f,0.f,0.f });
-			data[i].colours.assign(3 * pointsThisChunk, 0);
-			pointsSoFar += pointsThisChunk;
+			p.x = randomX(randomEng);
+			p.y = randomY(randomEng);
+			p.z = 0.f;
 		}
+	}
+
+	startFromBackFrame();
+}
+
+void DiffusionSimulator::initialise(const DataT &points)
+{
+	auto &data = frames.back();
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i].positions = points[i].positions;
+
+	startFromBackFrame();
+}
 
-		auto const randomXGen = [max = midPointX*2.0](){
-			return static_cast<float>(pointgen_random_uniform_double()*max);
-		};
+void DiffusionSimulator::startFromBackFrame()
+{
+	seedRandomStreams();
+	nUpdates = 0;
 
-		auto const randomYGen = [max = midPointY*2.0](){
-			return static_cast<float>(pointgen_random_uniform_double()*max);
-		};
+	for (auto &d : frames.back())
+	{
+		d.colours.assign(3 * d.positions.size(), 0);
 
-		// Random initial positions
-		for (auto &d : data)
+		if (layout == PointLayout::SOA)
 		{
-			for (auto &p : d.positions)
+			d.x.resize(d.positions.size());
+			d.y.resize(d.positions.size());
+			d.z.resize(d.positions.size());
+			for (size_t i = 0; i < d.positions.size(); ++i)
 			{
-				p.x = randomXGen();
-				p.y = randomYGen();
-				p.z = 0.f;
+				d.x[i] = d.positions[i].x;
+				d.y[i] = d.positions[i].y;
+				d.z[i] = d.positions[i].z;
 			}
 		}
-	});
+		else
+		{
+			d.x.clear();
+			d.y.clear();
+			d.z.clear();
+		}
+	}
+
+	frames.publish();
 }
 
 UpdateTimings DiffusionSimulator::update()
 {
-	return data.lockedModify<UpdateTimings>([this](DataT &data)
+	// Step on from the last frame into the back buffer, whose allocations are reused, while the reader may still have the last frame
+	auto const &last = frames.lastPublished();
+	auto &data = frames.back();
+
+	UpdateTimings timings;
+	prepareFrame(last, data, timings);
+	updatePositions(last, data, timings);
+	if (kernel == DiffusionKernel::SEPARATE)
 	{
-		UpdateTimings timings;
-		timings.updatePositionTime = updatePositions(data);
-		timings.updateColourTime == updateColours(data);
-		return timings;
-	});
+		timings.updateColourTime = updateColours(data);
+		if (layout == PointLayout::SOA)
+			timings.interleaveTime = interleave(data);
+	}
+
+	frames.publish();
+	return timings;
 }
 
-std::chrono::nanoseconds DiffusionSimulator::updatePositions(DataT &data)
+const DiffusionSimulator::DataT &DiffusionSimulator::latest()
+{
+	return frames.latest();
+}
+
+void DiffusionSimulator::prepareFrame(const DataT &last, DataT &data, UpdateTimings &timings) const
+{
+	for (size_t c = 0; c < data.size(); ++c)
+	{
+		auto const nPoints = last[c].positions.size();
+		data[c].positions.resize(nPoints);
+		data[c].colours.resize(3 * nPoints);
+		data[c].x.resize(last[c].x.size());
+		data[c].y.resize(last[c].y.size());
+		data[c].z.resize(last[c].z.size());
+	}
+
+	if (kernel == DiffusionKernel::SEPARATE)
+	{
+		timings.copyTime = timeParallelSweep(data.size(), nThreads, [this, &last, &data](size_t c)
+		{
+			copyPositions(last[c], data[c], 0, data[c].positions.size());
+		});
+	}
+}
+
+void DiffusionSimulator::updatePositions(const DataT &last, DataT &data, UpdateTimings &timings)
 {
 	auto const beforeTime = std::chrono::high_resolution_clock::now();
-	for (auto &d : data)
+
+	// Each chunk only uses its own random stream, so the result is the same whichever thread updates it
+	timings.updatePositionThreadTimes.assign(parallelWorkerCount(data.size(), nThreads), std::chrono::nanoseconds{});
+	forEachChunkInParallelOnWorkers(data.size(), nThreads, [this, &last, &data, &timings](size_t c, size_t worker)
 	{
-		for (auto &p : d.positions)
+		auto const chunkBeforeTime = std::chrono::high_resolution_clock::now();
+		updateChunk(last[c], data[c], c);
+		timings.updatePositionThreadTimes[worker] += std::chrono::high_resolution_clock::now() - chunkBeforeTime;
+	});
+
+	++nUpdates;
+	auto const timeTaken = std::chrono::high_resolution_clock::now() - beforeTime;
+	if (kernel == DiffusionKernel::FUSED)
+		timings.fusedUpdateTime = timeTaken;
+	else
+		timings.updatePositionTime = timeTaken;
+}
+
+void DiffusionSimulator::updateChunk(const PointDataArrays &last, PointDataArrays &chunk, size_t chunkIndex)
+{
+	// Blocks are small enough to stay in L1 cache between the steps of the fused pass
+	constexpr size_t pointsPerBlock = 256;
+
+	auto const nPoints = chunk.positions.size();
+	for (size_t first = 0; first < nPoints; first += pointsPerBlock)
+	{
+		auto const nInBlock = std::min(pointsPerBlock, nPoints - first);
+
+		if (kernel == DiffusionKernel::FUSED)
+			copyPositions(last, chunk, first, nInBlock);
+
+		if (randomMode == DiffusionRandomMode::PHILOX)
+			movePointsPhilox(chunk, chunkIndex, first, nInBlock);
+		else
+			movePointsStdNormal(chunk, chunkIndex, first, nInBlock);
+
+		if (kernel == DiffusionKernel::FUSED)
 		{
-			p.x += randomMovement(randomEng);
-			p.y += randomMovement(randomEng);
-			p.z += randomMovement(randomEng);
+			colourPoints(chunk, first, nInBlock);
+			if (layout == PointLayout::SOA)
+				interleavePositions(chunk.x.data() + first, chunk.y.data() + first, chunk.z.data() + first, nInBlock, chunk.positions.data() + first);
 		}
 	}
-	return std::chrono::high_resolution_clock::now() - beforeTime;
 }
 
-std::chrono::nanoseconds DiffusionSimulator::updateColours(DataT &data)
+void DiffusionSimulator::copyPositions(const PointDataArrays &last, PointDataArrays &chunk, size_t first, size_t n) const
 {
-	auto const beforeTime = std::chrono::high_resolution_clock::now();
-	for (auto &d : data)
+	// With SOA, positions are made from x, y and z by interleaving
+	if (layout == PointLayout::SOA)
 	{
-		assert(d.colours.size() == d.positions.size() * 3);
+		std::copy_n(last.x.data() + first, n, chunk.x.data() + first);
+		std::copy_n(last.y.data() + first, n, chunk.y.data() + first);
+		std::copy_n(last.z.data() + first, n, chunk.z.data() + first);
+	}
+	else
+	{
+		std::copy_n(last.positions.data() + first, n, chunk.positions.data() + first);
+	}
+}
 
-		for (size_t i = 0; i < d.positions.size(); ++i)
+void DiffusionSimulator::movePointsStdNormal(PointDataArrays &chunk, size_t chunkIndex, size_t first, size_t n)
+{
+	auto &randomEng = randomStreams[chunkIndex].randomEng;
+	auto &randomMovement = randomStreams[chunkIndex].randomMovement;
+	if (layout == PointLayout::SOA)
+	{
+		for (auto i = first; i < first + n; ++i)
 		{
-			// Base colour on Z position
-			d.colours[3 * i] = 255;
-			d.colours[3 * i + 1] = 0;
-			d.colours[3 * i + 2] = static_cast<unsigned char>(std::min(255.f, std::max(0.f, 5.f*d.positions[i].z + (255.f*0.5f))));
+			chunk.x[i] += randomMovement(randomEng);
+			chunk.y[i] += randomMovement(randomEng);
+			chunk.z[i] += randomMovement(randomEng);
 		}
+		return;
 	}
-	return std::chrono::high_resolution_clock::now() - beforeTime;
-}
\ No newline at end of file
+
+	for (auto i = first; i < first + n; ++i)
+	{
+		auto &p = chunk.positions[i];
+		p.x += randomMovement(randomEng);
+		p.y += randomMovement(randomEng);
+		p.z += randomMovement(randomEng);
+	}
+}
+
+void DiffusionSimulator::movePointsPhilox(PointDataArrays &chunk, size_t chunkIndex, size_t first, size_t n) const
+{
+	constexpr size_t maxPoints = 256;
+	alignas(CACHE_LINE_SIZE) float movements[3][maxPoints];
+	assert(n <= maxPoints);
+
+	const PhiloxKey key = { masterSeed, static_cast<uint32_t>(chunkIndex) };
+	for (size_t axis = 0; axis < 3; ++axis)
+		fillGaussian(movements[axis], n, 0.f, 2.f, key, 3 * nUpdates + axis, first, simdLevel);
+
+	if (layout == PointLayout::SOA)
+	{
+		auto *const x = chunk.x.data() + first;
+		auto *const y = chunk.y.data() + first;
+		auto *const z = chunk.z.data() + first;
+		for (size_t i = 0; i < n; ++i)
+			x[i] += movements[0][i];
+		for (size_t i = 0; i < n; ++i)
+			y[i] += movements[1][i];
+		for (size_t i = 0; i < n; ++i)
+			z[i] += movements[2][i];
+		return;
+	}
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		auto &p = chunk.positions[first + i];
+		p.x += movements[0][i];
+		p.y += movements[1][i];
+		p.z += movements[2][i];
+	}
+}
+
+void DiffusionSimulator::colourPoints(PointDataArrays &chunk, size_t first, size_t n) const
+{
+	// Base colour on Z position
+	auto const colourFromZ = [](float z)
+	{
+		return static_cast<unsigned char>(std::min(255.f, std::max(0.f, 5.f*z + (255.f*0.5f))));
+	};
+
+	auto const colour = [&chunk, &colourFromZ, first, n](const auto &zAt)
+	{
+		for (auto i = first; i < first + n; ++i)
+		{
+			chunk.colours[3 * i] = 255;
+			chunk.colours[3 * i + 1] = 0;
+			chunk.colours[3 * i + 2] = colourFromZ(zAt(i));
+		}
+	};
+
+	if (layout == PointLayout::SOA)
+		colour([z = chunk.z.data()](size_t i) { return z[i]; });
+	else
+		colour([p = chunk.positions.data()](size_t i) { return p[i].z; });
+}
+
+std::chrono::nanoseconds DiffusionSimulator::updateColours(DataT &data) const
+{
+	return timeParallelSweep(data.size(), nThreads, [this, &data](size_t c)
+	{
+		auto &d = data[c];
+		assert(d.colours.size() == d.positions.size() * 3);
+		colourPoints(d, 0, d.positions.size());
+	});
+}
+
+std::chrono::nanoseconds DiffusionSimulator::interleave(DataT &data) const
+{
+	return timeParallelSweep(data.size(), nThreads, [&data](size_t c)
+	{
+		auto &d = data[c];
+		interleavePositions(d.x.data(), d.y.data(), d.z.data(), d.x.size(), d.positions.data());
+	});
+}
+
+void reindeer::interleavePositions(const float *x, const float *y, const float *z, size_t nPoints, XYZ<float> *positions)
+{
+	for (size_t i = 0; i < nPoints; ++i)
+		positions[i] = { x[i], y[i], z[i] };
+}
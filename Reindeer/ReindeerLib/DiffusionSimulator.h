@@ -4,8 +4,12 @@
 #include <random>
 #include <cassert>
 #include <atomic>
+#include <chrono>
+#include <vector>
 
-#include "MutexedObject.h"
+#include "AlignedVector.h"
+#include "SimdDispatch.h"
+#include "TripleBuffer.h"
 #include "XYZ.hpp"
 
 namespace reindeer
@@ -14,16 +18,67 @@ namespace reindeer
 	// and vertex and colour arrays for OpenGL
 	// In use, we should maintain the following:
 	// positions.size() * 3 == colours.size()
+	// With PointLayout::SOA, x, y and z are the positions and positions is their interleaved copy,
+	// otherwise x, y and z are empty
 	struct PointDataArrays
 	{
 		std::vector<XYZ<float>> positions;
 		std::vector<unsigned char> colours;
+
+		AlignedVector<float> x;
+		AlignedVector<float> y;
+		AlignedVector<float> z;
 	};
 
+	// Packs the x, y and z columns into vertices (e.g. for renderers that need packed vertices)
+	void interleavePositions(const float *x, const float *y, const float *z, size_t nPoints, XYZ<float> *positions);
+
+	// With DiffusionKernel::SEPARATE each sweep is timed on its own (each across the same threads), and fusedUpdateTime is 0
+	// With DiffusionKernel::FUSED only fusedUpdateTime is set
 	struct UpdateTimings
 	{
+		// Carrying the last frame's positions into the new frame
+		std::chrono::nanoseconds copyTime = {};
+
 		std::chrono::nanoseconds updatePositionTime = {};
 		std::chrono::nanoseconds updateColourTime = {};
+
+		// Packing x, y and z into positions, only with PointLayout::SOA
+		std::chrono::nanoseconds interleaveTime = {};
+
+		// The single pass doing all of the above
+		std::chrono::nanoseconds fusedUpdateTime = {};
+
+		// Time each thread spent in the parallel pass (updating positions, or the fused pass)
+		std::vector<std::chrono::nanoseconds> updatePositionThreadTimes;
+	};
+
+	// How the random movements are made
+	enum class DiffusionRandomMode
+	{
+		// std::normal_distribution on a std::mt19937 per chunk
+		STD_NORMAL,
+		// Blocks of Philox counter based values (see fillGaussian), keyed by the master seed and chunk,
+		// with a stream per update and axis
+		PHILOX
+	};
+
+	// How positions are stored while simulating
+	enum class PointLayout
+	{
+		// In positions
+		AOS,
+		// In separate aligned x, y and z arrays, which are interleaved into positions at the end of each update
+		SOA
+	};
+
+	// How the sweeps over the points are arranged
+	enum class DiffusionKernel
+	{
+		// Copy, positions, colours and interleaving each sweep all the points
+		SEPARATE,
+		// One parallel pass does them all a block of points at a time, while the block is still in cache
+		FUSED
 	};
 
 	class DiffusionSimulator
@@ -34,24 +89,79 @@ namespace reindeer
 
 	public:
 
+		// Seeds from std::random_device and uses all hardware threads
 		DiffusionSimulator();
+
+		// Each update runs on up to nThreads threads (0 uses all hardware threads)
+		// The starting and moved positions only depend on masterSeed and randomMode, not the number of threads, the layout or the kernel
+		DiffusionSimulator(uint32_t masterSeed, unsigned nThreads, DiffusionRandomMode randomMode = DiffusionRandomMode::STD_NORMAL,
+			PointLayout layout = PointLayout::AOS, DiffusionKernel kernel = DiffusionKernel::SEPARATE);
+
 		~DiffusionSimulator();
 
 		// Data arrays
 		using DataT = std::array<PointDataArrays, nChunks>;
-		obelisk::MutexedObject<DataT> data;
 
+		// initialise and update publish frames for one other thread (e.g. a renderer) to read through latest()
+		// They must be called from one thread at a time, and never wait for the reader
+
+		// Random points across width x height
 		void initialise(size_t totalPoints, float width, float height);
+
+		// Starts from the positions of the given points
+		void initialise(const DataT &points);
+
 		UpdateTimings update();
+
+		// Reader only: the latest published frame, which isn't changed until the next call
+		// Doesn't lock, so never waits for an update
+		const DataT &latest();
 		
+
 	private:
 
-		std::chrono::nanoseconds updatePositions(DataT &data);
-		std::chrono::nanoseconds updateColours(DataT &data);
+		// Sizes data like last, and copies the positions across unless the fused pass will
+		void prepareFrame(const DataT &last, DataT &data, UpdateTimings &timings) const;
+
+		// The parallel pass, which moves the points, and with DiffusionKernel::FUSED also copies, colours and interleaves them
+		void updatePositions(const DataT &last, DataT &data, UpdateTimings &timings);
+		void updateChunk(const PointDataArrays &last, PointDataArrays &chunk, size_t chunkIndex);
+
+		// Each works on points [first, first + n) of a chunk
+		void copyPositions(const PointDataArrays &last, PointDataArrays &chunk, size_t first, size_t n) const;
+		void movePointsStdNormal(PointDataArrays &chunk, size_t chunkIndex, size_t first, size_t n);
+		void movePointsPhilox(PointDataArrays &chunk, size_t chunkIndex, size_t first, size_t n) const;
+		void colourPoints(PointDataArrays &chunk, size_t first, size_t n) const;
+
+		std::chrono::nanoseconds updateColours(DataT &data) const;
+		std::chrono::nanoseconds interleave(DataT &data) const;
+
+		// Restart each chunk's random stream from the master seed
+		void seedRandomStreams();
+
+		// Sets up the back frame's layout, restarts the random streams and publishes it
+		void startFromBackFrame();
+
+		TripleBuffer<DataT> frames;
+
+		const uint32_t masterSeed;
+		const unsigned nThreads;
+		const DiffusionRandomMode randomMode;
+		const PointLayout layout;
+		const DiffusionKernel kernel;
+		const SimdLevel simdLevel;
+
+		// Updates since initialise, used as the Philox stream
+		uint64_t nUpdates = 0;
 
 		// Random number generators
-		std::mt19937 randomEng = std::mt19937(std::random_device()());
+		// Each chunk has its own stream, seeded from the master seed and the chunk index, so chunks can be updated in parallel
+		struct RandomStream
+		{
+			std::mt19937 randomEng;
+			std::normal_distribution<float> randomMovement = std::normal_distribution<float>(0.f, 2.f);
+		};
+		std::array<RandomStream, nChunks> randomStreams;
 		std::uniform_int<uint8_t> randomColour = std::uniform_int<uint8_t>(0, 255);
-		std::normal_distribution<float> randomMovement = std::normal_distribution<float>(0.f, 2.f);
 	};
 }
@@ -0,0 +1,177 @@
+#include "ElevationFilters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "DistributionFunctions.hpp"
+
+#include "AlignedVector.h"
+
+using namespace reindeer;
+
+namespace
+{
+	// Samples are filtered in blocks small enough to stay in L1 cache
+	constexpr size_t SAMPLES_PER_BLOCK = 1024;
+
+	// Weights for each sample of a 1D gaussian, from the CDF over the sample's width
+	// (the 1D equivalent of obelisk::create2DGaussianKernel, normalised)
+	std::vector<double> createGaussianKernel(double sigma)
+	{
+		const auto halfWidth = static_cast<size_t>(std::ceil(3.0 * sigma));
+
+		std::vector<double> kernel(2 * halfWidth + 1);
+		for (size_t j = 0; j < kernel.size(); ++j)
+		{
+			const auto x = static_cast<double>(j) - static_cast<double>(halfWidth);
+			kernel[j] = obelisk::gaussianCDF(0.0, sigma, x + 0.5) - obelisk::gaussianCDF(0.0, sigma, x - 0.5);
+		}
+
+		double sum = 0.0;
+		for (const auto k : kernel)
+			sum += k;
+
+		for (auto &k : kernel)
+			k /= sum;
+
+		return kernel;
+	}
+
+	// Convolves the values in place with a symmetric, normalised kernel of odd size
+	// Samples beyond the ends are left out, and the remaining weights renormalised
+	void convolveInPlace(double *values, size_t nValues, const std::vector<double> &kernel)
+	{
+		const auto halfWidth = kernel.size() / 2;
+		if (nValues == 0 || halfWidth == 0)
+			return;
+
+		// For the samples within halfWidth of each end, the weights that fall within the values
+		// (the same at both ends, as the kernel is symmetric)
+		std::vector<double> edgeWeights(std::min(halfWidth, nValues));
+		for (size_t i = 0; i < edgeWeights.size(); ++i)
+		{
+			double weight = 0.0;
+			for (size_t j = halfWidth - i; j < kernel.size() && j - (halfWidth - i) < nValues; ++j)
+				weight += kernel[j];
+			edgeWeights[i] = weight;
+		}
+
+		// The original values of a block plus halfWidth either side (zero beyond the ends)
+		// The values before the block have already been overwritten, so are carried over from the previous block
+		AlignedVector<double> window(SAMPLES_PER_BLOCK + 2 * halfWidth, 0.0);
+		AlignedVector<double> sums(SAMPLES_PER_BLOCK);
+
+		const auto fillWindow = [values, nValues, &window](size_t windowBegin, size_t valuesBegin)
+		{
+			for (auto w = windowBegin; w < window.size(); ++w)
+			{
+				const auto v = valuesBegin + (w - windowBegin);
+				window[w] = v < nValues ? values[v] : 0.0;
+			}
+		};
+
+		fillWindow(halfWidth, 0);
+		for (size_t first = 0; first < nValues; first += SAMPLES_PER_BLOCK)
+		{
+			const auto nInBlock = std::min(SAMPLES_PER_BLOCK, nValues - first);
+			if (first > 0)
+			{
+				std::memmove(window.data(), window.data() + SAMPLES_PER_BLOCK, 2 * halfWidth * sizeof(double));
+				fillWindow(2 * halfWidth, first + halfWidth);
+			}
+
+			// One pass over the block per weight, so the inner loop is independent multiply-adds that can be vectorised
+			std::fill(sums.begin(), sums.end(), 0.0);
+			for (size_t j = 0; j < kernel.size(); ++j)
+			{
+				const auto weight = kernel[j];
+				const double *const shifted = window.data() + j;
+				double *const s = sums.data();
+				for (size_t k = 0; k < nInBlock; ++k)
+					s[k] += weight * shifted[k];
+			}
+
+			std::copy(sums.begin(), sums.begin() + nInBlock, values + first);
+		}
+
+		for (size_t i = 0; i < edgeWeights.size(); ++i)
+		{
+			values[i] /= edgeWeights[i];
+			if (nValues - 1 - i >= edgeWeights.size())
+				values[nValues - 1 - i] /= edgeWeights[i];
+		}
+	}
+
+	template <typename Fn>
+	void smoothGpxElevations(std::vector<GpxPoint> &gpxData, Fn smooth)
+	{
+		AlignedVector<double> elevation_m(gpxData.size());
+		for (size_t i = 0; i < gpxData.size(); ++i)
+			elevation_m[i] = gpxData[i].elevation_m;
+
+		smooth(elevation_m.data(), elevation_m.size());
+
+		for (size_t i = 0; i < gpxData.size(); ++i)
+			gpxData[i].elevation_m = elevation_m[i];
+	}
+}
+
+namespace reindeer
+{
+	void smoothElevationMovingAverage(double *elevation_m, size_t nSamples, size_t halfWidth)
+	{
+		const std::vector<double> kernel(2 * halfWidth + 1, 1.0 / static_cast<double>(2 * halfWidth + 1));
+		convolveInPlace(elevation_m, nSamples, kernel);
+	}
+
+	void smoothElevationMovingAverage(std::vector<GpxPoint> &gpxData, size_t halfWidth)
+	{
+		smoothGpxElevations(gpxData, [halfWidth](double *elevation_m, size_t nSamples)
+		{
+			smoothElevationMovingAverage(elevation_m, nSamples, halfWidth);
+		});
+	}
+
+	void smoothElevationGaussian(double *elevation_m, size_t nSamples, double sigma)
+	{
+		if (!(sigma > 0.0))
+			throw std::invalid_argument("Gaussian sigma must be positive");
+
+		convolveInPlace(elevation_m, nSamples, createGaussianKernel(sigma));
+	}
+
+	void smoothElevationGaussian(std::vector<GpxPoint> &gpxData, double sigma)
+	{
+		smoothGpxElevations(gpxData, [sigma](double *elevation_m, size_t nSamples)
+		{
+			smoothElevationGaussian(elevation_m, nSamples, sigma);
+		});
+	}
+
+	void smoothElevationHysteresis(double *elevation_m, size_t nSamples, double threshold_m)
+	{
+		if (!(threshold_m >= 0.0))
+			throw std::invalid_argument("Hysteresis threshold must not be negative");
+
+		// Each output depends on the previous one, so this is a single sequential pass
+		if (nSamples == 0)
+			return;
+
+		auto output_m = elevation_m[0];
+		for (size_t i = 1; i < nSamples; ++i)
+		{
+			output_m = std::min(std::max(output_m, elevation_m[i] - threshold_m), elevation_m[i] + threshold_m);
+			elevation_m[i] = output_m;
+		}
+	}
+
+	void smoothElevationHysteresis(std::vector<GpxPoint> &gpxData, double threshold_m)
+	{
+		smoothGpxElevations(gpxData, [threshold_m](double *elevation_m, size_t nSamples)
+		{
+			smoothElevationHysteresis(elevation_m, nSamples, threshold_m);
+		});
+	}
+}
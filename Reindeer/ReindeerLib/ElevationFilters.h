@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+#include "ActivityStructures.h"
+
+namespace reindeer
+{
+	// Elevation smoothing, to stop GPS noise adding to ElevationInfo::cumulativeElevation_m
+	// Each filters a column of elevations in place, or the elevations of gpx points
+	// Widths are in samples, so resample onto a fixed grid first (see TrackResampler) for the same smoothing at any sample rate
+
+	// Mean of the samples within halfWidth either side
+	// Near the ends, the mean of the samples that exist (as obelisk::boxBlur3x3 does at its edges)
+	void smoothElevationMovingAverage(double *elevation_m, size_t nSamples, size_t halfWidth);
+	void smoothElevationMovingAverage(std::vector<GpxPoint> &gpxData, size_t halfWidth);
+
+	// Gaussian weighted mean, out to 3 sigma either side (renormalised near the ends)
+	// Throws std::invalid_argument if sigma isn't positive
+	void smoothElevationGaussian(double *elevation_m, size_t nSamples, double sigma);
+	void smoothElevationGaussian(std::vector<GpxPoint> &gpxData, double sigma);
+
+	// Only follows the elevation once it moves more than threshold_m from the output, and then lags it by threshold_m
+	// So changes smaller than threshold_m (e.g. noise on the flat) are ignored entirely
+	// Throws std::invalid_argument if threshold_m is negative
+	void smoothElevationHysteresis(double *elevation_m, size_t nSamples, double threshold_m);
+	void smoothElevationHysteresis(std::vector<GpxPoint> &gpxData, double threshold_m);
+}
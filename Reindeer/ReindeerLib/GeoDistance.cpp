@@ -0,0 +1,126 @@
+#include "GeoDistance.h"
+
+#include <algorithm>
+#include <intrin.h>
+
+using namespace reindeer;
+
+namespace
+{
+	// Points are converted in blocks small enough to stay in L1 cache
+	constexpr size_t POINTS_PER_BLOCK = 256;
+
+	// Per point terms, so the pair kernels only need arithmetic
+	struct alignas(32) PointTermsBlock
+	{
+		double latitude_rad[POINTS_PER_BLOCK];
+		double longitude_rad[POINTS_PER_BLOCK];
+		double cosLatitude[POINTS_PER_BLOCK];
+	};
+
+	void calculatePointTerms(const GpxPoint *points, const size_t begin, const size_t end, PointTermsBlock &terms)
+	{
+		for (auto i = begin; i < end; ++i)
+		{
+			terms.latitude_rad[i] = points[i].latitude * RADIANS_PER_DEGREE;
+			terms.longitude_rad[i] = points[i].longitude * RADIANS_PER_DEGREE;
+			terms.cosLatitude[i] = std::cos(terms.latitude_rad[i]);
+		}
+	}
+
+	// Each kernel finds the distance to points [begin, end) in the block from the point before, as equirectangularDistance_m
+	void pairDistancesScalar(const PointTermsBlock &terms, const size_t begin, const size_t end, double *distances_m)
+	{
+		for (auto i = begin; i < end; ++i)
+		{
+			distances_m[i] = equirectangularDistance_m(
+				terms.latitude_rad[i - 1], terms.longitude_rad[i - 1], terms.cosLatitude[i - 1],
+				terms.latitude_rad[i], terms.longitude_rad[i], terms.cosLatitude[i]);
+		}
+	}
+
+	size_t pairDistancesSse2(const PointTermsBlock &terms, const size_t begin, const size_t end, double *distances_m)
+	{
+		const auto radius = _mm_set1_pd(EARTH_RADIUS_m);
+		const auto twoPi = _mm_set1_pd(2.0 * PI);
+		const auto signBit = _mm_set1_pd(-0.0);
+
+		auto i = begin;
+		for (; i + 2 <= end; i += 2)
+		{
+			const auto latDiff = _mm_sub_pd(_mm_loadu_pd(terms.latitude_rad + i), _mm_loadu_pd(terms.latitude_rad + i - 1));
+			const auto absLongDiff = _mm_andnot_pd(signBit, _mm_sub_pd(_mm_loadu_pd(terms.longitude_rad + i), _mm_loadu_pd(terms.longitude_rad + i - 1)));
+			const auto longDiff = _mm_min_pd(absLongDiff, _mm_sub_pd(twoPi, absLongDiff));
+			const auto cosProduct = _mm_mul_pd(_mm_loadu_pd(terms.cosLatitude + i - 1), _mm_loadu_pd(terms.cosLatitude + i));
+			const auto sumSquares = _mm_add_pd(_mm_mul_pd(latDiff, latDiff), _mm_mul_pd(cosProduct, _mm_mul_pd(longDiff, longDiff)));
+			_mm_storeu_pd(distances_m + i, _mm_mul_pd(radius, _mm_sqrt_pd(sumSquares)));
+		}
+
+		return i;
+	}
+
+	size_t pairDistancesAvx2(const PointTermsBlock &terms, const size_t begin, const size_t end, double *distances_m)
+	{
+		const auto radius = _mm256_set1_pd(EARTH_RADIUS_m);
+		const auto twoPi = _mm256_set1_pd(2.0 * PI);
+		const auto signBit = _mm256_set1_pd(-0.0);
+
+		auto i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			const auto latDiff = _mm256_sub_pd(_mm256_loadu_pd(terms.latitude_rad + i), _mm256_loadu_pd(terms.latitude_rad + i - 1));
+			const auto absLongDiff = _mm256_andnot_pd(signBit, _mm256_sub_pd(_mm256_loadu_pd(terms.longitude_rad + i), _mm256_loadu_pd(terms.longitude_rad + i - 1)));
+			const auto longDiff = _mm256_min_pd(absLongDiff, _mm256_sub_pd(twoPi, absLongDiff));
+			const auto cosProduct = _mm256_mul_pd(_mm256_loadu_pd(terms.cosLatitude + i - 1), _mm256_loadu_pd(terms.cosLatitude + i));
+			const auto sumSquares = _mm256_add_pd(_mm256_mul_pd(latDiff, latDiff), _mm256_mul_pd(cosProduct, _mm256_mul_pd(longDiff, longDiff)));
+			_mm256_storeu_pd(distances_m + i, _mm256_mul_pd(radius, _mm256_sqrt_pd(sumSquares)));
+		}
+
+		return i;
+	}
+
+	void pairDistances(const PointTermsBlock &terms, const size_t begin, const size_t end, double *distances_m, const SimdLevel simdLevel)
+	{
+		runSimdKernels(simdLevel, begin, end,
+			[&terms, distances_m](size_t i, size_t n) { return pairDistancesAvx2(terms, i, n, distances_m); },
+			[&terms, distances_m](size_t i, size_t n) { return pairDistancesSse2(terms, i, n, distances_m); },
+			[&terms, distances_m](size_t i, size_t n) { pairDistancesScalar(terms, i, n, distances_m); });
+	}
+}
+
+void reindeer::calculateStepDistances(const GpxPoint *points, size_t nPoints, double *stepDistances_m)
+{
+	static const auto simdLevel = detectSimdLevel();
+	calculateStepDistances(points, nPoints, stepDistances_m, simdLevel);
+}
+
+void reindeer::calculateStepDistances(const GpxPoint *points, size_t nPoints, double *stepDistances_m, SimdLevel simdLevel)
+{
+	if (nPoints == 0)
+		return;
+
+	stepDistances_m[0] = 0.0;
+
+	// Consecutive blocks overlap by one point, so every pair is within a block
+	// The terms for the shared point are carried over rather than recalculated
+	PointTermsBlock terms;
+	calculatePointTerms(points, 0, 1, terms);
+	for (size_t first = 0; first + 1 < nPoints; first += POINTS_PER_BLOCK - 1)
+	{
+		const auto nInBlock = std::min(POINTS_PER_BLOCK, nPoints - first);
+		calculatePointTerms(points + first, 1, nInBlock, terms);
+		pairDistances(terms, 1, nInBlock, stepDistances_m + first, simdLevel);
+
+		const auto last = nInBlock - 1;
+		terms.latitude_rad[0] = terms.latitude_rad[last];
+		terms.longitude_rad[0] = terms.longitude_rad[last];
+		terms.cosLatitude[0] = terms.cosLatitude[last];
+	}
+}
+
+std::vector<double> reindeer::calculateStepDistances(const std::vector<GpxPoint> &points)
+{
+	std::vector<double> stepDistances_m(points.size());
+	calculateStepDistances(points.data(), points.size(), stepDistances_m.data());
+	return stepDistances_m;
+}
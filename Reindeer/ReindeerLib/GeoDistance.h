@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+#include "ActivityStructures.h"
+#include "SimdDispatch.h"
+
+namespace reindeer
+{
+	// Distances between consecutive points, where stepDistances_m[i] is from point i - 1 to point i (and stepDistances_m[0] is 0)
+	// stepDistances_m must have room for nPoints values
+	// Identical to DistTimeElev::fromGpx on each pair, but the trig is done once per point and the pairs are done in SIMD lanes
+	void calculateStepDistances(const GpxPoint *points, size_t nPoints, double *stepDistances_m);
+
+	// Uses a particular SIMD level, which must be supported
+	void calculateStepDistances(const GpxPoint *points, size_t nPoints, double *stepDistances_m, SimdLevel simdLevel);
+
+	std::vector<double> calculateStepDistances(const std::vector<GpxPoint> &points);
+}
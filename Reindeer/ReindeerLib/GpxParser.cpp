@@ -0,0 +1,265 @@
+#include "GpxParser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "MemoryMappedFile.h"
+#include "Timestamp.h"
+
+using namespace reindeer;
+
+namespace
+{
+	bool isSpace(const char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	const char *skipSpace(const char *p, const char *end)
+	{
+		while (p < end && isSpace(*p))
+			++p;
+
+		return p;
+	}
+
+	void trimSpace(const char *&begin, const char *&end)
+	{
+		begin = skipSpace(begin, end);
+		while (end > begin && isSpace(end[-1]))
+			--end;
+	}
+
+	bool startsWith(const char *p, const char *end, const char *prefix, const size_t prefixLength)
+	{
+		return static_cast<size_t>(end - p) >= prefixLength && std::memcmp(p, prefix, prefixLength) == 0;
+	}
+
+	// Is there a tag with this name at p (which points after the '<')
+	bool isTag(const char *p, const char *end, const char *name, const size_t nameLength)
+	{
+		if (!startsWith(p, end, name, nameLength))
+			return false;
+
+		const auto after = p + nameLength;
+		return after == end || isSpace(*after) || *after == '>' || *after == '/';
+	}
+
+	// The next "<name" tag at or after p, or end
+	const char *findTag(const char *p, const char *end, const char *name, const size_t nameLength)
+	{
+		for (;;)
+		{
+			p = static_cast<const char *>(std::memchr(p, '<', end - p));
+			if (!p)
+				return end;
+
+			++p;
+			if (isTag(p, end, name, nameLength))
+				return p - 1;
+		}
+	}
+
+	// Parses a decimal number filling [begin, end), ignoring surrounding white space
+	// Up to 19 significant digits are exact integers, so scaling by an exact power of ten gives the correctly rounded value
+	// Anything else falls back to strtod
+	double parseDouble(const char *begin, const char *end)
+	{
+		trimSpace(begin, end);
+
+		auto p = begin;
+		const auto negative = p < end && *p == '-';
+		if (p < end && (*p == '-' || *p == '+'))
+			++p;
+
+		uint64_t mantissa = 0;
+		int nDigits = 0;
+		int exponent = 0;
+		bool anyDigits = false;
+		for (; p < end && *p >= '0' && *p <= '9'; ++p, anyDigits = true)
+		{
+			if (nDigits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+				nDigits += mantissa > 0 ? 1 : 0;
+			}
+			else
+			{
+				++exponent;
+			}
+		}
+
+		if (p < end && *p == '.')
+		{
+			for (++p; p < end && *p >= '0' && *p <= '9'; ++p, anyDigits = true)
+			{
+				if (nDigits < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+					nDigits += mantissa > 0 ? 1 : 0;
+					--exponent;
+				}
+			}
+		}
+
+		static const double exactPowersOf10[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+		constexpr uint64_t maxExactMantissa = uint64_t(1) << 53;
+		if (anyDigits && p == end && mantissa <= maxExactMantissa && exponent >= -22 && exponent <= 22)
+		{
+			const auto magnitude = exponent < 0 ?
+				static_cast<double>(mantissa) / exactPowersOf10[-exponent] :
+				static_cast<double>(mantissa) * exactPowersOf10[exponent];
+
+			return negative ? -magnitude : magnitude;
+		}
+
+		// Exponents, long mantissas etc.
+		char buffer[64];
+		const auto length = static_cast<size_t>(end - begin);
+		if (length == 0 || length >= sizeof(buffer))
+			throw std::runtime_error("Invalid number in GPX data");
+
+		std::memcpy(buffer, begin, length);
+		buffer[length] = '\0';
+
+		char *parsedEnd = nullptr;
+		const auto value = std::strtod(buffer, &parsedEnd);
+		if (parsedEnd != buffer + length)
+			throw std::runtime_error("Invalid number in GPX data");
+
+		return value;
+	}
+
+	// The value of an attribute in [tagBegin, tagEnd), or false if it isn't there
+	bool findAttribute(const char *tagBegin, const char *tagEnd, const char *name, const size_t nameLength,
+		const char *&valueBegin, const char *&valueEnd)
+	{
+		for (auto p = tagBegin; p + nameLength < tagEnd; ++p)
+		{
+			if (!isSpace(p[-1]) || !startsWith(p, tagEnd, name, nameLength))
+				continue;
+
+			auto q = skipSpace(p + nameLength, tagEnd);
+			if (q == tagEnd || *q != '=')
+				continue;
+
+			q = skipSpace(q + 1, tagEnd);
+			if (q == tagEnd || (*q != '"' && *q != '\''))
+				continue;
+
+			const auto quote = *q;
+			valueBegin = q + 1;
+			valueEnd = static_cast<const char *>(std::memchr(valueBegin, quote, tagEnd - valueBegin));
+			return valueEnd != nullptr;
+		}
+
+		return false;
+	}
+
+	// Parses the track point starting at p (its '<'), returning where it ends
+	const char *parseTrackPoint(const char *p, const char *end, std::vector<GpxPoint> &points)
+	{
+		static const char trkptTag[] = "trkpt";
+		static const char eleTag[] = "ele";
+		static const char timeTag[] = "time";
+		static const char trkptCloseTag[] = "/trkpt";
+
+		const auto tagBegin = p + sizeof(trkptTag);
+		const auto tagEnd = static_cast<const char *>(std::memchr(tagBegin, '>', end - tagBegin));
+		if (!tagEnd)
+			throw std::runtime_error("Unterminated track point in GPX data");
+
+		const char *latBegin, *latEnd, *lonBegin, *lonEnd;
+		if (!findAttribute(tagBegin, tagEnd, "lat", 3, latBegin, latEnd) ||
+			!findAttribute(tagBegin, tagEnd, "lon", 3, lonBegin, lonEnd))
+		{
+			throw std::runtime_error("Track point without lat/lon in GPX data");
+		}
+
+		double elevation_m = 0.0;
+		uint64_t dateTime_ms = 0;
+
+		// Children, unless the tag closes itself
+		p = tagEnd + 1;
+		if (tagEnd[-1] != '/')
+		{
+			for (;;)
+			{
+				p = static_cast<const char *>(std::memchr(p, '<', end - p));
+				if (!p)
+					throw std::runtime_error("Unterminated track point in GPX data");
+
+				++p;
+				if (isTag(p, end, trkptCloseTag, sizeof(trkptCloseTag) - 1))
+				{
+					p += sizeof(trkptCloseTag) - 1;
+					break;
+				}
+
+				const auto isEle = isTag(p, end, eleTag, sizeof(eleTag) - 1);
+				const auto isTime = !isEle && isTag(p, end, timeTag, sizeof(timeTag) - 1);
+				if (!isEle && !isTime)
+					continue;
+
+				const auto valueBegin = static_cast<const char *>(std::memchr(p, '>', end - p));
+				const auto valueEnd = valueBegin ? static_cast<const char *>(std::memchr(valueBegin, '<', end - valueBegin)) : nullptr;
+				if (!valueEnd)
+					throw std::runtime_error("Unterminated element in GPX data");
+
+				auto valueTextBegin = valueBegin + 1;
+				auto valueTextEnd = valueEnd;
+				trimSpace(valueTextBegin, valueTextEnd);
+				if (isEle)
+					elevation_m = parseDouble(valueTextBegin, valueTextEnd);
+				else
+					dateTime_ms = parseIso8601_ms(valueTextBegin, valueTextEnd);
+
+				p = valueEnd;
+			}
+		}
+
+		points.push_back(GpxPoint(parseDouble(lonBegin, lonEnd), parseDouble(latBegin, latEnd), elevation_m, dateTime_ms));
+		return p;
+	}
+}
+
+std::vector<GpxPoint> reindeer::parseGpx(const char *data, size_t size)
+{
+	static const char trkptTag[] = "trkpt";
+	constexpr auto trkptLength = sizeof(trkptTag) - 1;
+
+	std::vector<GpxPoint> points;
+	if (size == 0)
+		return points;
+
+	const auto end = data + size;
+	auto p = findTag(data, end, trkptTag, trkptLength);
+	if (p == end)
+		return points;
+
+	// Estimate the number of points from the spacing of the first two, with some slack so one allocation is usually enough
+	const auto second = findTag(p + 1, end, trkptTag, trkptLength);
+	if (second != end)
+	{
+		const auto bytesPerPoint = static_cast<double>(second - p);
+		points.reserve(static_cast<size_t>(1.1 * static_cast<double>(end - p) / bytesPerPoint) + 1);
+	}
+
+	while (p != end)
+	{
+		p = parseTrackPoint(p, end, points);
+		p = findTag(p, end, trkptTag, trkptLength);
+	}
+
+	return points;
+}
+
+std::vector<GpxPoint> reindeer::readGpxFile(const std::wstring &path)
+{
+	const MemoryMappedFile file(path);
+	return parseGpx(file.data(), file.size());
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ActivityStructures.h"
+
+namespace reindeer
+{
+	// Reads the track points (<trkpt lat="..." lon="...">, with optional <ele> and <time>) from GPX data
+	// Scans the text in place, without building a DOM or allocating per node
+	// Points without <ele> have an elevation of 0, and without <time> a dateTime_ms of 0
+	// Throws std::runtime_error if a track point's values can't be read
+	std::vector<GpxPoint> parseGpx(const char *data, size_t size);
+
+	// Memory maps the file and parses it
+	// Throws std::runtime_error if the file can't be read
+	std::vector<GpxPoint> readGpxFile(const std::wstring &path);
+}
@@ -0,0 +1,67 @@
+#include "MemoryMappedFile.h"
+
+#include <stdexcept>
+
+#define NOMINMAX
+#include <windows.h>
+
+using namespace reindeer;
+
+struct MemoryMappedFile::Impl
+{
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+	const char *view = nullptr;
+	size_t size = 0;
+
+	~Impl()
+	{
+		if (view)
+			UnmapViewOfFile(view);
+
+		if (mapping)
+			CloseHandle(mapping);
+
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+	}
+};
+
+MemoryMappedFile::MemoryMappedFile(const std::wstring &path) :
+	impl(std::make_unique<Impl>())
+{
+	impl->file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (impl->file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Failed to open file for memory mapping");
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(impl->file, &fileSize))
+		throw std::runtime_error("Failed to get size of file for memory mapping");
+
+	impl->size = static_cast<size_t>(fileSize.QuadPart);
+
+	// Empty files can't be mapped
+	if (impl->size == 0)
+		return;
+
+	impl->mapping = CreateFileMappingW(impl->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!impl->mapping)
+		throw std::runtime_error("Failed to create file mapping");
+
+	impl->view = static_cast<const char *>(MapViewOfFile(impl->mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!impl->view)
+		throw std::runtime_error("Failed to map view of file");
+}
+
+MemoryMappedFile::~MemoryMappedFile() = default;
+
+const char *MemoryMappedFile::data() const
+{
+	return impl->view;
+}
+
+size_t MemoryMappedFile::size() const
+{
+	return impl->size;
+}
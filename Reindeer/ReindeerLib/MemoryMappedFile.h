@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace reindeer
+{
+	// Read-only view of a whole file mapped into memory
+	// Pages are only read from disk when they are first accessed
+	class MemoryMappedFile
+	{
+	public:
+		// Throws std::runtime_error if the file can't be opened or mapped
+		explicit MemoryMappedFile(const std::wstring &path);
+		~MemoryMappedFile();
+
+		MemoryMappedFile(const MemoryMappedFile &) = delete;
+		MemoryMappedFile &operator=(const MemoryMappedFile &) = delete;
+
+		// nullptr if the file is empty
+		const char *data() const;
+		size_t size() const;
+
+	private:
+		struct Impl;
+		const std::unique_ptr<Impl> impl;
+	};
+}
@@ -3,7 +3,15 @@
 #include "ContainerUtils.h"
 #include "Optional.h"
 
+#include "ParallelHelpers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
 #include <set>
+#include <stdexcept>
+#include <tuple>
 
 using namespace reindeer;
 using namespace obelisk;
@@ -25,55 +33,130 @@ namespace
 	{
 		return isImprovement(current.distanceTime, candidate.distanceTime);
 	}
-}
 
-std::vector<PaceCurvePoint> reindeer::calculatePaceCurve(
-	const std::vector<GpxPoint> &gpxData,
-	const double min_m,
-	const double resolution_m,
-	const double minElevationDiff_m)
-{
-	// Find total distance
-	double totalDistance_m = 0.0;
-	for (size_t i = 1; i < gpxData.size(); ++i)
+	double calculateTotalDistance(const std::vector<GpxPoint> &gpxData)
 	{
-		totalDistance_m += DistTimeElev::fromGpx(gpxData[0], gpxData[1]).distanceTime.distance_m;
+		double totalDistance_m = 0.0;
+		for (size_t i = 1; i < gpxData.size(); ++i)
+		{
+			totalDistance_m += DistTimeElev::fromGpx(gpxData[i - 1], gpxData[i]).distanceTime.distance_m;
+		}
+
+		return totalDistance_m;
 	}
 
 	// Find the distances we want to find paces for
-	std::vector<PaceCurvePoint> bestPacePerDistance;
-	for (unsigned i = 0; ; ++i)
+	std::vector<double> calculateTargetDistances(
+		const double totalDistance_m,
+		const double min_m,
+		const double resolution_m)
 	{
-		const auto distance_m = min_m + resolution_m * static_cast<double>(i);
-		if (distance_m > totalDistance_m)
-			break;
+		std::vector<double> targetDistances;
+		for (unsigned i = 0; ; ++i)
+		{
+			const auto distance_m = min_m + resolution_m * static_cast<double>(i);
+			if (distance_m > totalDistance_m)
+				break;
 
-		// Only assign distance, we assign other values when we find a valid segment
-		// when time_s == 0 we know it hasn't been set yet
-		bestPacePerDistance.push_back(PaceCurvePoint(distance_m, DistTimeElev::zero()));
+			targetDistances.push_back(distance_m);
+		}
+
+		return targetDistances;
 	}
-	
-	// Loop through every subsegment
-	for (size_t i = 0; i < gpxData.size(); ++i)
+
+	// Only the targets up to the total (distance or duration) can be covered by a segment
+	std::vector<double> reachableTargets(const std::vector<double> &targets, const double total)
+	{
+		if (!std::is_sorted(targets.begin(), targets.end()))
+			throw std::invalid_argument("Targets must be in increasing order");
+
+		return std::vector<double>(targets.begin(), std::upper_bound(targets.begin(), targets.end(), total));
+	}
+
+	// Filter out invalid paces
+	std::vector<PaceCurvePoint> filterUnsetPaces(const std::vector<PaceCurvePoint> &bestPacePerDistance)
 	{
-		auto cumulativeSubSegment = DistTimeElev::zero();
-		for (size_t j = i + 1; j < gpxData.size(); ++j)
+		std::vector<PaceCurvePoint> filtered;
+		for (const auto &best : bestPacePerDistance)
 		{
-			const auto distTime = DistTimeElev::fromGpx(gpxData[j - 1], gpxData[j]);
-			cumulativeSubSegment = DistTimeElev::sum(cumulativeSubSegment, distTime);
-			// If the elevation diff doesn't fit the criteria, ignore
-			if (cumulativeSubSegment.elevation.elevationDiff_m < minElevationDiff_m)
-				continue;
+			if (best.bestPaceSegment.distanceTime.time_s > 0.0)
+			{
+				PaceCurvePoint p(best.distance_m, best.bestPaceSegment);
+				filtered.push_back(p);
+			}
+		}
 
-			// Go through best paces to see if we have improved on any
-			for (size_t k = 0; k < bestPacePerDistance.size(); ++k)
+		return filtered;
+	}
+
+	// Split the points [0, nPoints) into ranges with a similar number of sub-segments in each
+	// Later start indices have fewer segments (or, if splitting on end index, earlier end indices do)
+	std::vector<size_t> balancedChunkBounds(const size_t nPoints, const size_t nChunks, const bool splitOnEndIndex)
+	{
+		std::vector<size_t> bounds = { 0 };
+		for (size_t c = 1; c < nChunks; ++c)
+		{
+			const auto fraction = static_cast<double>(c) / static_cast<double>(nChunks);
+			const auto n = static_cast<double>(nPoints);
+			const auto bound = splitOnEndIndex ?
+				n * std::sqrt(fraction) :
+				n - n * std::sqrt(1.0 - fraction);
+
+			bounds.push_back(std::max(bounds.back(), std::min(nPoints, static_cast<size_t>(bound))));
+		}
+		bounds.push_back(nPoints);
+
+		return bounds;
+	}
+
+	// How many chunks to split work into - more chunks than threads so they balance as they finish
+	size_t chunkCountForThreads(const unsigned nThreads, const size_t maxChunks)
+	{
+		constexpr size_t chunksPerThread = 8;
+		const auto nThreadsResolved = resolveThreadCount(nThreads);
+		if (nThreadsResolved <= 1)
+			return 1;
+
+		return std::max<size_t>(1, std::min(maxChunks, nThreadsResolved * chunksPerThread));
+	}
+
+	// Best paces for segments starting in [fromBegin, fromEnd)
+	// Paces that haven't been set have time_s == 0
+	std::vector<PaceCurvePoint> calculateBestPacesExhaustive(
+		const std::vector<GpxPoint> &gpxData,
+		const std::vector<double> &targetDistances,
+		const double minElevationDiff_m,
+		const size_t fromBegin,
+		const size_t fromEnd)
+	{
+		// Only assign distance, we assign other values when we find a valid segment
+		// when time_s == 0 we know it hasn't been set yet
+		std::vector<PaceCurvePoint> bestPacePerDistance;
+		for (const auto distance_m : targetDistances)
+		{
+			bestPacePerDistance.push_back(PaceCurvePoint(distance_m, DistTimeElev::zero()));
+		}
+
+		// Loop through every subsegment
+		for (size_t i = fromBegin; i < fromEnd; ++i)
+		{
+			auto cumulativeSubSegment = DistTimeElev::zero();
+			for (size_t j = i + 1; j < gpxData.size(); ++j)
 			{
-				const auto bestPaceIndex = bestPacePerDistance.size() - 1 - k;
-				auto &bestPace = bestPacePerDistance[bestPaceIndex];
-				// Is the distance within the current distance
-				if (bestPace.distance_m <=
-					cumulativeSubSegment.distanceTime.distance_m)
+				const auto distTime = DistTimeElev::fromGpx(gpxData[j - 1], gpxData[j]);
+				cumulativeSubSegment = DistTimeElev::sum(cumulativeSubSegment, distTime);
+				// If the elevation diff doesn't fit the criteria, ignore
+				if (cumulativeSubSegment.elevation.elevationDiff_m < minElevationDiff_m)
+					continue;
+
+				// Go through best paces for the distances within the current distance to see if we have improved on any
+				// Binary search for the longest one, the targets can be any sorted grid
+				const auto firstLonger = std::upper_bound(targetDistances.begin(), targetDistances.end(),
+					cumulativeSubSegment.distanceTime.distance_m);
+				for (auto k = std::distance(targetDistances.begin(), firstLonger); k > 0; --k)
 				{
+					auto &bestPace = bestPacePerDistance[k - 1];
+
 					// If we have found a valid pace and it's better than the current sub segment
 					// We can break the loop because no shorter distance will have an improvement
 					if (bestPace.bestPaceSegment.distanceTime.time_s != 0.0 &&
@@ -83,63 +166,1117 @@ std::vector<PaceCurvePoint> reindeer::calculatePaceCurve(
 					}
 
 					// This is an improvement, so replace
-					bestPace.bestPaceSegment = cumulativeSubSegment;					
+					bestPace.bestPaceSegment = cumulativeSubSegment;
 				}
 			}
 		}
+
+		return bestPacePerDistance;
 	}
 
-	// Filter out invalid paces
-	std::vector<PaceCurvePoint> filtered;
-	for (const auto &best : bestPacePerDistance)
+	std::vector<PaceCurvePoint> calculatePaceCurveExhaustive(
+		const std::vector<GpxPoint> &gpxData,
+		const std::vector<double> &targetDistances,
+		const double minElevationDiff_m,
+		const unsigned nThreads)
 	{
-		if (best.bestPaceSegment.distanceTime.time_s > 0.0)
+		// Each chunk of start indices finds its own best paces
+		const auto nChunks = chunkCountForThreads(nThreads, gpxData.size());
+		const auto bounds = balancedChunkBounds(gpxData.size(), nChunks, false);
+		std::vector<std::vector<PaceCurvePoint>> bestPacesPerChunk(nChunks);
+		forEachChunkInParallel(nChunks, nThreads, [&](size_t c)
+		{
+			bestPacesPerChunk[c] = calculateBestPacesExhaustive(
+				gpxData, targetDistances, minElevationDiff_m, bounds[c], bounds[c + 1]);
+		});
+
+		// Combine in start index order, so on equal paces we keep the segment a single thread would have found first
+		auto bestPacePerDistance = std::move(bestPacesPerChunk.front());
+		for (size_t c = 1; c < nChunks; ++c)
 		{
-			PaceCurvePoint p(best.distance_m, best.bestPaceSegment);
-			filtered.push_back(p);
+			for (size_t k = 0; k < bestPacePerDistance.size(); ++k)
+			{
+				auto &bestPace = bestPacePerDistance[k].bestPaceSegment;
+				const auto &chunkPace = bestPacesPerChunk[c][k].bestPaceSegment;
+				if (chunkPace.distanceTime.time_s == 0.0)
+					continue;
+
+				if (bestPace.distanceTime.time_s == 0.0 || isImprovement(bestPace, chunkPace))
+					bestPace = chunkPace;
+			}
 		}
+
+		return filterUnsetPaces(bestPacePerDistance);
 	}
 
-	return filtered;
-}
+	// A sub-segment between two gpx point indices
+	struct SegmentCandidate
+	{
+		DistTimeElev segment = DistTimeElev::zero();
+		size_t from = 0;
+		size_t to = 0;
+		bool valid = false;
 
-std::vector<PaceCurvePoint> reindeer::mergePaceCurves(const std::vector<std::vector<PaceCurvePoint>> &paceCurves)
-{
-	// More each unique distance, find the best time
-	std::map<double, PaceCurvePoint> distanceToBestPoint;
-	for (const auto &paceCurve : paceCurves)
+		SegmentCandidate() = default;
+
+		SegmentCandidate(DistTimeElev segment, size_t from, size_t to) :
+			segment(segment), from(from), to(to), valid(true)
+		{
+		}
+	};
+
+	// Ranks the same as the exhaustive search
+	// If pace and distance are equal, it keeps the segment it found first (it visits segments in (from, to) order)
+	bool isImprovement(const SegmentCandidate &current, const SegmentCandidate &candidate)
+	{
+		if (!candidate.valid)
+			return false;
+
+		if (!current.valid)
+			return true;
+
+		if (isImprovement(current.segment, candidate.segment))
+			return true;
+
+		if (isImprovement(candidate.segment, current.segment))
+			return false;
+
+		return std::make_tuple(candidate.from, candidate.to) < std::make_tuple(current.from, current.to);
+	}
+
+	// The smallest elevation diff of any sub-segment (infinity if there are none)
+	double minSegmentElevationDiff(const ActivityColumns &activity)
+	{
+		auto minDiff_m = std::numeric_limits<double>::infinity();
+		if (activity.size() < 2)
+			return minDiff_m;
+
+		// The smallest diff ending at each point is from the highest point before it
+		auto highestSoFar_m = activity.elevationDiff_m[0];
+		for (size_t to = 1; to < activity.size(); ++to)
+		{
+			minDiff_m = std::min(minDiff_m, activity.elevationDiff_m[to] - highestSoFar_m);
+			highestSoFar_m = std::max(highestSoFar_m, activity.elevationDiff_m[to]);
+		}
+
+		return minDiff_m;
+	}
+
+	// What targets are measured in - distance for pace curves, time for duration curves
+	// A segment covers a target if its length on this axis is at least the target
+	struct TargetAxis
+	{
+		AlignedVector<double> ActivityColumns::*column;
+		double DistanceTime::*segmentLength;
+
+		double length(const DistTimeElev &segment) const
+		{
+			return segment.distanceTime.*segmentLength;
+		}
+	};
+
+	const TargetAxis DISTANCE_AXIS = { &ActivityColumns::distance_m, &DistanceTime::distance_m };
+	const TargetAxis TIME_AXIS = { &ActivityColumns::time_s, &DistanceTime::time_s };
+
+	// Does every sub-segment have an elevation diff of at least minElevationDiff_m?
+	bool elevationCriteriaAlwaysMet(const ActivityColumns &activity, const double minElevationDiff_m)
+	{
+		return minSegmentElevationDiff(activity) >= minElevationDiff_m;
+	}
+
+	// Searches for the best segment covering at least the target, one end point at a time - O(log n) per point
+	// Treat each point as (time, distance), so the pace of a segment is the slope between its ends
+	// As 'to' increases, the valid 'from' points form a growing window [0, nextFrom)
+	// The fastest start point for 'to' is on the lower convex hull of that window, where the slope to 'to' is unimodal
+	class BestSegmentSearch
+	{
+	public:
+		// Start points before firstFrom are ignored
+		BestSegmentSearch(double target, const TargetAxis &axis, size_t firstFrom = 0) :
+			target(target), axis(axis), nextFrom(firstFrom)
+		{
+		}
+
+		// End points must be added in order
+		void addEndPoint(const ActivityColumns &activity, const size_t to)
+		{
+			const auto &d = activity.distance_m;
+			const auto &t = activity.time_s;
+			const auto &covered = activity.*axis.column;
+
+			// Is b above the line from a to c
+			const auto isAboveChord = [&d, &t](size_t a, size_t b, size_t c)
+			{
+				return (t[b] - t[a]) * (d[c] - d[a]) - (d[b] - d[a]) * (t[c] - t[a]) < 0.0;
+			};
+
+			// Is the pace from b to 'to' faster than the pace from a to 'to' (a and b are consecutive hull points)
+			const auto isFasterFromNext = [&d, &t, to](size_t a, size_t b)
+			{
+				return (d[b] - d[a]) * (t[to] - t[b]) < (d[to] - d[b]) * (t[b] - t[a]);
+			};
+
+			// Collinear points are kept so that, on equal paces, we choose the earliest (longest) start
+			for (; nextFrom < to && covered[to] - covered[nextFrom] >= target; ++nextFrom)
+			{
+				while (hull.size() >= 2 && isAboveChord(hull[hull.size() - 2], hull.back(), nextFrom))
+					hull.pop_back();
+
+				hull.push_back(nextFrom);
+			}
+
+			if (hull.empty())
+				return;
+
+			// Binary search for the first hull point where the pace stops increasing
+			size_t lower = 0;
+			size_t upper = hull.size() - 1;
+			while (lower < upper)
+			{
+				const auto mid = lower + (upper - lower) / 2;
+				if (isFasterFromNext(hull[mid], hull[mid + 1]))
+					lower = mid + 1;
+				else
+					upper = mid;
+			}
+
+			const auto candidate = SegmentCandidate(activity.segment(hull[lower], to), hull[lower], to);
+			if (isImprovement(best, candidate))
+				best = candidate;
+		}
+
+		const SegmentCandidate &bestSegment() const
+		{
+			return best;
+		}
+
+	private:
+		double target;
+		TargetAxis axis;
+		std::vector<size_t> hull;
+		size_t nextFrom;
+		SegmentCandidate best;
+	};
+
+	// Compare every segment ending at 'to' against the largest target it covers - O(n log k)
+	void addSegmentsEndingAt(
+		const ActivityColumns &activity,
+		const size_t to,
+		const std::vector<double> &targets,
+		const double minElevationDiff_m,
+		const TargetAxis &axis,
+		std::vector<SegmentCandidate> &bestPerLargestTarget)
 	{
+		for (size_t from = 0; from < to; ++from)
+		{
+			const auto segment = activity.segment(from, to);
+			// If the elevation diff doesn't fit the criteria, ignore
+			if (segment.elevation.elevationDiff_m < minElevationDiff_m)
+				continue;
+
+			const auto firstLonger = std::upper_bound(targets.begin(), targets.end(), axis.length(segment));
+			if (firstLonger == targets.begin())
+				continue;
+
+			auto &best = bestPerLargestTarget[std::distance(targets.begin(), firstLonger) - 1];
+			const auto candidate = SegmentCandidate(segment, from, to);
+			if (isImprovement(best, candidate))
+				best = candidate;
+		}
+	}
+
+	// As addSegmentsEndingAt, for each of the (sorted) elevation thresholds the segment meets
+	void addSegmentsEndingAtForThresholds(
+		const ActivityColumns &activity,
+		const size_t to,
+		const std::vector<double> &targetDistances,
+		const std::vector<double> &minElevationDiffs_m,
+		std::vector<std::vector<SegmentCandidate>> &bestPerLargestTargetPerThreshold)
+	{
+		for (size_t from = 0; from < to; ++from)
+		{
+			const auto segment = activity.segment(from, to);
+			const auto firstUnmet = std::upper_bound(
+				minElevationDiffs_m.begin(), minElevationDiffs_m.end(), segment.elevation.elevationDiff_m);
+			if (firstUnmet == minElevationDiffs_m.begin())
+				continue;
+
+			const auto firstLonger = std::upper_bound(
+				targetDistances.begin(), targetDistances.end(), segment.distanceTime.distance_m);
+			if (firstLonger == targetDistances.begin())
+				continue;
+
+			const auto k = std::distance(targetDistances.begin(), firstLonger) - 1;
+			const auto candidate = SegmentCandidate(segment, from, to);
+
+			// A stricter threshold sees a subset of the segments a laxer one does, so its best is never better
+			// Going from the strictest threshold met, we can stop at the first one that isn't improved
+			for (auto e = std::distance(minElevationDiffs_m.begin(), firstUnmet); e > 0; --e)
+			{
+				auto &best = bestPerLargestTargetPerThreshold[e - 1][k];
+				if (!isImprovement(best, candidate))
+					break;
+
+				best = candidate;
+			}
+		}
+	}
+
+	// A segment that covers a longer distance also covers every shorter one
+	std::vector<SegmentCandidate> cascadeToShorterTargets(std::vector<SegmentCandidate> bestPerLargestTarget)
+	{
+		for (size_t k = bestPerLargestTarget.size(); k > 1; --k)
+		{
+			if (isImprovement(bestPerLargestTarget[k - 2], bestPerLargestTarget[k - 1]))
+				bestPerLargestTarget[k - 2] = bestPerLargestTarget[k - 1];
+		}
+
+		return bestPerLargestTarget;
+	}
+
+	std::vector<PaceCurvePoint> toPaceCurve(
+		const std::vector<double> &targetDistances,
+		const std::vector<SegmentCandidate> &bestPerTarget)
+	{
+		std::vector<PaceCurvePoint> bestPacePerDistance;
+		for (size_t k = 0; k < targetDistances.size(); ++k)
+		{
+			bestPacePerDistance.push_back(PaceCurvePoint(targetDistances[k], bestPerTarget[k].segment));
+		}
+
+		return filterUnsetPaces(bestPacePerDistance);
+	}
+
+	// The best segment covering each target
+	std::vector<SegmentCandidate> findBestSegmentsPrefixSum(
+		const ActivityColumns &activity,
+		const std::vector<double> &targets,
+		const double minElevationDiff_m,
+		const TargetAxis &axis,
+		const unsigned nThreads)
+	{
+		// The hull search can't apply the elevation criteria, so only use it when the criteria can't exclude anything
+		// Otherwise choose whichever search is cheaper for this many points and targets
+		const auto nPoints = static_cast<double>(activity.size());
+		const auto hullSearchCost = static_cast<double>(targets.size()) * nPoints * (1.0 + std::log2(std::max(nPoints, 1.0)));
+		const auto allSegmentsCost = 0.5 * nPoints * nPoints;
+		const auto useHullSearch = hullSearchCost < allSegmentsCost &&
+			elevationCriteriaAlwaysMet(activity, minElevationDiff_m);
+
+		std::vector<SegmentCandidate> bestPerTarget(targets.size());
+		if (useHullSearch)
+		{
+			// Each target is independent
+			forEachChunkInParallel(targets.size(), nThreads, [&](size_t k)
+			{
+				BestSegmentSearch search(targets[k], axis);
+				for (size_t to = 1; to < activity.size(); ++to)
+					search.addEndPoint(activity, to);
+
+				bestPerTarget[k] = search.bestSegment();
+			});
+		}
+		else
+		{
+			// Visit each sub-segment once - O(n^2 + k)
+			// Each chunk of end indices keeps its own best per target, SegmentCandidate ranking doesn't depend on visit order
+			const auto nChunks = chunkCountForThreads(nThreads, activity.size());
+			const auto bounds = balancedChunkBounds(activity.size(), nChunks, true);
+			std::vector<std::vector<SegmentCandidate>> bestPerLargestTargetPerChunk(nChunks);
+			forEachChunkInParallel(nChunks, nThreads, [&](size_t c)
+			{
+				auto &bestPerLargestTarget = bestPerLargestTargetPerChunk[c];
+				bestPerLargestTarget.resize(targets.size());
+				for (auto to = std::max<size_t>(bounds[c], 1); to < bounds[c + 1]; ++to)
+					addSegmentsEndingAt(activity, to, targets, minElevationDiff_m, axis, bestPerLargestTarget);
+			});
+
+			auto bestPerLargestTarget = std::move(bestPerLargestTargetPerChunk.front());
+			for (size_t c = 1; c < nChunks; ++c)
+			{
+				for (size_t k = 0; k < bestPerLargestTarget.size(); ++k)
+				{
+					if (isImprovement(bestPerLargestTarget[k], bestPerLargestTargetPerChunk[c][k]))
+						bestPerLargestTarget[k] = bestPerLargestTargetPerChunk[c][k];
+				}
+			}
+
+			bestPerTarget = cascadeToShorterTargets(std::move(bestPerLargestTarget));
+		}
+
+		return bestPerTarget;
+	}
+
+	std::vector<PaceCurvePoint> calculatePaceCurvePrefixSum(
+		const ActivityColumns &activity,
+		const std::vector<double> &targetDistances,
+		const double minElevationDiff_m,
+		const unsigned nThreads)
+	{
+		return toPaceCurve(targetDistances,
+			findBestSegmentsPrefixSum(activity, targetDistances, minElevationDiff_m, DISTANCE_AXIS, nThreads));
+	}
+
+	std::vector<std::vector<PaceCurvePoint>> calculatePaceCurvesPrefixSum(
+		const ActivityColumns &activity,
+		const std::vector<double> &targetDistances,
+		const std::vector<double> &minElevationDiffs_m,
+		const unsigned nThreads)
+	{
+		std::vector<std::vector<PaceCurvePoint>> paceCurves(minElevationDiffs_m.size());
+
+		// Thresholds that no segment fails all have the same curve, which may not need every segment visited
+		const auto firstFiltering = std::upper_bound(
+			minElevationDiffs_m.begin(), minElevationDiffs_m.end(), minSegmentElevationDiff(activity));
+		const auto nUnfiltered = static_cast<size_t>(std::distance(minElevationDiffs_m.begin(), firstFiltering));
+		if (nUnfiltered > 0)
+		{
+			const auto unfiltered = calculatePaceCurvePrefixSum(activity, targetDistances, minElevationDiffs_m.front(), nThreads);
+			std::fill(paceCurves.begin(), paceCurves.begin() + nUnfiltered, unfiltered);
+		}
+
+		const std::vector<double> filteringThresholds(firstFiltering, minElevationDiffs_m.end());
+		if (filteringThresholds.empty())
+			return paceCurves;
+
+		// Visit each sub-segment once for all the remaining thresholds - O(n^2 + k)
+		const auto nChunks = chunkCountForThreads(nThreads, activity.size());
+		const auto bounds = balancedChunkBounds(activity.size(), nChunks, true);
+		std::vector<std::vector<std::vector<SegmentCandidate>>> bestPerThresholdPerChunk(nChunks);
+		forEachChunkInParallel(nChunks, nThreads, [&](size_t c)
+		{
+			auto &bestPerThreshold = bestPerThresholdPerChunk[c];
+			bestPerThreshold.assign(filteringThresholds.size(), std::vector<SegmentCandidate>(targetDistances.size()));
+			for (auto to = std::max<size_t>(bounds[c], 1); to < bounds[c + 1]; ++to)
+				addSegmentsEndingAtForThresholds(activity, to, targetDistances, filteringThresholds, bestPerThreshold);
+		});
+
+		for (size_t e = 0; e < filteringThresholds.size(); ++e)
+		{
+			auto bestPerLargestTarget = std::move(bestPerThresholdPerChunk.front()[e]);
+			for (size_t c = 1; c < nChunks; ++c)
+			{
+				for (size_t k = 0; k < bestPerLargestTarget.size(); ++k)
+				{
+					if (isImprovement(bestPerLargestTarget[k], bestPerThresholdPerChunk[c][e][k]))
+						bestPerLargestTarget[k] = bestPerThresholdPerChunk[c][e][k];
+				}
+			}
+
+			paceCurves[nUnfiltered + e] = toPaceCurve(targetDistances, cascadeToShorterTargets(std::move(bestPerLargestTarget)));
+		}
+
+		return paceCurves;
+	}
+
+	// Cascade down targets (if we have a shorter target with a worse pace, replace with the longer target's segment)
+	// Works for pace and duration curves
+	template <typename CurvePoint>
+	void cascadeDownTargets(std::vector<CurvePoint> &bestPoints)
+	{
+		for (size_t i = 1; i < bestPoints.size(); ++i)
+		{
+			const auto reverseIndex = bestPoints.size() - 1 - i;
+			auto &currentPoint = bestPoints[reverseIndex];
+			const auto &bestWithLongerTarget = bestPoints[reverseIndex + 1].bestPaceSegment;
+			if (isImprovement(currentPoint.bestPaceSegment, bestWithLongerTarget))
+			{
+				currentPoint.bestPaceSegment = bestWithLongerTarget;
+			}
+		}
+	}
+
+	bool hasIncreasingDistances(const std::vector<PaceCurvePoint> &paceCurve)
+	{
+		return std::adjacent_find(paceCurve.begin(), paceCurve.end(), [](const PaceCurvePoint &a, const PaceCurvePoint &b) {
+			return !(a.distance_m < b.distance_m);
+		}) == paceCurve.end();
+	}
+
+	// Sort on distance, keeping the best point for each distance
+	// On equal paces the earlier point is kept, as mergePaceCurves would
+	std::vector<PaceCurvePoint> toIncreasingDistances(std::vector<PaceCurvePoint> paceCurve)
+	{
+		if (hasIncreasingDistances(paceCurve))
+			return paceCurve;
+
+		std::stable_sort(paceCurve.begin(), paceCurve.end(), [](const PaceCurvePoint &a, const PaceCurvePoint &b) {
+			return a.distance_m < b.distance_m;
+		});
+
+		std::vector<PaceCurvePoint> unique;
 		for (const auto &p : paceCurve)
 		{
-			const auto thisDistance = p.distance_m;
-			auto existing = distanceToBestPoint.find(thisDistance);
-			// If we don't have a point for this distance, or the pace is an approvement
-			// Add/replace
-			if (existing == distanceToBestPoint.end() ||
-				isImprovement(existing->second.bestPaceSegment, p.bestPaceSegment))
+			if (unique.empty() || unique.back().distance_m < p.distance_m)
+				unique.push_back(p);
+			else if (isImprovement(unique.back().bestPaceSegment, p.bestPaceSegment))
+				unique.back() = p;
+		}
+
+		return unique;
+	}
+
+	// Merge two pace curves with increasing distances, keeping the best point for each distance
+	// On equal paces the point from 'earlier' is kept, as mergePaceCurves would
+	std::vector<PaceCurvePoint> mergeIncreasingPaceCurves(
+		const std::vector<PaceCurvePoint> &earlier,
+		const std::vector<PaceCurvePoint> &later)
+	{
+		std::vector<PaceCurvePoint> merged;
+		merged.reserve(earlier.size() + later.size());
+
+		auto itEarlier = earlier.begin();
+		auto itLater = later.begin();
+		while (itEarlier != earlier.end() && itLater != later.end())
+		{
+			if (itEarlier->distance_m < itLater->distance_m)
+			{
+				merged.push_back(*itEarlier++);
+			}
+			else if (itLater->distance_m < itEarlier->distance_m)
+			{
+				merged.push_back(*itLater++);
+			}
+			else
+			{
+				merged.push_back(isImprovement(itEarlier->bestPaceSegment, itLater->bestPaceSegment) ? *itLater : *itEarlier);
+				++itEarlier;
+				++itLater;
+			}
+		}
+
+		merged.insert(merged.end(), itEarlier, earlier.end());
+		merged.insert(merged.end(), itLater, later.end());
+
+		return merged;
+	}
+
+	// The best segment covering targetDistance_m within points [first, last]
+	SegmentCandidate findBestSegmentWithin(
+		const ActivityColumns &activity,
+		const size_t first,
+		const size_t last,
+		const double targetDistance_m,
+		const double minElevationDiff_m,
+		const bool elevationCriteriaMet)
+	{
+		if (elevationCriteriaMet)
+		{
+			BestSegmentSearch search(targetDistance_m, DISTANCE_AXIS, first);
+			for (auto to = first + 1; to <= last; ++to)
+				search.addEndPoint(activity, to);
+
+			return search.bestSegment();
+		}
+
+		SegmentCandidate best;
+		for (auto from = first; from < last; ++from)
+		{
+			for (auto to = from + 1; to <= last; ++to)
+			{
+				const auto segment = activity.segment(from, to);
+				if (segment.distanceTime.distance_m < targetDistance_m ||
+					segment.elevation.elevationDiff_m < minElevationDiff_m)
+					continue;
+
+				const auto candidate = SegmentCandidate(segment, from, to);
+				if (isImprovement(best, candidate))
+					best = candidate;
+			}
+		}
+
+		return best;
+	}
+
+	// Picks the best segment, then the best segment that doesn't overlap it, and so on (segments may share an end point)
+	// Each pick splits the gap it was in, so only the two new gaps need searching
+	std::vector<LocatedSegment> findBestEfforts(
+		const ActivityColumns &activity,
+		const double targetDistance_m,
+		const double minElevationDiff_m,
+		const bool elevationCriteriaMet,
+		const size_t maxEfforts)
+	{
+		struct Gap
+		{
+			size_t first;
+			size_t last;
+			SegmentCandidate best;
+		};
+
+		const auto searchGap = [&](size_t first, size_t last)
+		{
+			return Gap{ first, last, findBestSegmentWithin(activity, first, last, targetDistance_m, minElevationDiff_m, elevationCriteriaMet) };
+		};
+
+		std::vector<LocatedSegment> efforts;
+		if (activity.size() < 2)
+			return efforts;
+
+		std::vector<Gap> gaps = { searchGap(0, activity.size() - 1) };
+		while (efforts.size() < maxEfforts)
+		{
+			size_t bestGap = 0;
+			for (size_t g = 1; g < gaps.size(); ++g)
+			{
+				if (isImprovement(gaps[bestGap].best, gaps[g].best))
+					bestGap = g;
+			}
+
+			const auto gap = gaps[bestGap];
+			if (!gap.best.valid)
+				break;
+
+			efforts.push_back(LocatedSegment(gap.best.segment, gap.best.from, gap.best.to));
+
+			gaps[bestGap] = searchGap(gap.first, gap.best.from);
+			gaps.push_back(searchGap(gap.best.to, gap.last));
+		}
+
+		return efforts;
+	}
+
+	// Keeps the first and last points, and enough points in between that no two consecutive kept points are more than
+	// maxGapTime_s apart, unless they're neighbours in the original
+	// Every original point is then within maxGapTime_s of a kept point on either side
+	// The kept points have the original running totals, so segments between them are exact
+	ActivityColumns decimateOnTime(const ActivityColumns &activity, const double maxGapTime_s)
+	{
+		ActivityColumns decimated;
+		const auto keep = [&activity, &decimated](size_t i)
+		{
+			decimated.distance_m.push_back(activity.distance_m[i]);
+			decimated.time_s.push_back(activity.time_s[i]);
+			decimated.elevationDiff_m.push_back(activity.elevationDiff_m[i]);
+			decimated.cumulativeElevation_m.push_back(activity.cumulativeElevation_m[i]);
+		};
+
+		if (activity.empty())
+			return decimated;
+
+		size_t lastKept = 0;
+		keep(lastKept);
+		for (size_t i = 1; i < activity.size(); ++i)
+		{
+			const auto isLast = i + 1 == activity.size();
+			if (isLast || activity.time_s[i + 1] - activity.time_s[lastKept] > maxGapTime_s)
+			{
+				keep(i);
+				lastKept = i;
+			}
+		}
+
+		return decimated;
+	}
+
+	// For each unique target, keep the best point, then cascade down
+	// On equal paces the earlier point is kept
+	template <typename CurvePoint>
+	std::vector<CurvePoint> mergeCurves(const std::vector<std::vector<CurvePoint>> &curves, double CurvePoint::*target)
+	{
+		std::map<double, CurvePoint> targetToBestPoint;
+		for (const auto &curve : curves)
+		{
+			for (const auto &p : curve)
 			{
-				distanceToBestPoint[thisDistance] = p;
+				// If we don't have a point for this target, or the pace is an improvement
+				// Add/replace
+				const auto existing = targetToBestPoint.find(p.*target);
+				if (existing == targetToBestPoint.end() ||
+					isImprovement(existing->second.bestPaceSegment, p.bestPaceSegment))
+				{
+					targetToBestPoint[p.*target] = p;
+				}
 			}
 		}
+
+		// Get ordered values from map
+		auto bestPoints = convertAll<CurvePoint>(targetToBestPoint,
+			[](const std::pair<double, CurvePoint> &kv){
+			return kv.second;
+		});
+
+		cascadeDownTargets(bestPoints);
+
+		return bestPoints;
 	}
 
-	// Get ordered values from map
-	auto bestPoints = convertAll<PaceCurvePoint>(distanceToBestPoint,
-		[](const std::pair<double, PaceCurvePoint> &kv){
-		return kv.second;
+	// The furthest distance covered by a segment lasting at most each target duration (0 if none meets the elevation criteria)
+	std::vector<double> findFurthestDistances(
+		const ActivityColumns &activity,
+		const std::vector<double> &targetDurations_s,
+		const double minElevationDiff_m,
+		const unsigned nThreads)
+	{
+		const auto &d = activity.distance_m;
+		const auto &t = activity.time_s;
+		std::vector<double> furthestPerTarget_m(targetDurations_s.size(), 0.0);
+		if (elevationCriteriaAlwaysMet(activity, minElevationDiff_m))
+		{
+			// Distance never decreases, so the furthest segment ending at 'to' starts at the earliest point in the window - O(n) per target
+			forEachChunkInParallel(targetDurations_s.size(), nThreads, [&](size_t k)
+			{
+				size_t from = 0;
+				for (size_t to = 1; to < activity.size(); ++to)
+				{
+					while (from < to && t[to] - t[from] > targetDurations_s[k])
+						++from;
+
+					if (from < to)
+						furthestPerTarget_m[k] = std::max(furthestPerTarget_m[k], d[to] - d[from]);
+				}
+			});
+
+			return furthestPerTarget_m;
+		}
+
+		// Visit each sub-segment once, against the shortest target it fits in - O(n^2 log k)
+		const auto nChunks = chunkCountForThreads(nThreads, activity.size());
+		const auto bounds = balancedChunkBounds(activity.size(), nChunks, true);
+		std::vector<std::vector<double>> furthestPerShortestTargetPerChunk(nChunks, furthestPerTarget_m);
+		forEachChunkInParallel(nChunks, nThreads, [&](size_t c)
+		{
+			auto &furthestPerShortestTarget_m = furthestPerShortestTargetPerChunk[c];
+			for (auto to = std::max<size_t>(bounds[c], 1); to < bounds[c + 1]; ++to)
+			{
+				for (size_t from = 0; from < to; ++from)
+				{
+					const auto segment = activity.segment(from, to);
+					if (segment.elevation.elevationDiff_m < minElevationDiff_m)
+						continue;
+
+					const auto firstCovering = std::lower_bound(
+						targetDurations_s.begin(), targetDurations_s.end(), segment.distanceTime.time_s);
+					if (firstCovering == targetDurations_s.end())
+						continue;
+
+					auto &furthest_m = furthestPerShortestTarget_m[std::distance(targetDurations_s.begin(), firstCovering)];
+					furthest_m = std::max(furthest_m, segment.distanceTime.distance_m);
+				}
+			}
+		});
+
+		// A segment within a shorter duration is also within every longer one
+		for (size_t k = 0; k < furthestPerTarget_m.size(); ++k)
+		{
+			for (const auto &furthestPerShortestTarget_m : furthestPerShortestTargetPerChunk)
+				furthestPerTarget_m[k] = std::max(furthestPerTarget_m[k], furthestPerShortestTarget_m[k]);
+
+			if (k > 0)
+				furthestPerTarget_m[k] = std::max(furthestPerTarget_m[k], furthestPerTarget_m[k - 1]);
+		}
+
+		return furthestPerTarget_m;
+	}
+
+	std::vector<DurationCurvePoint> toDurationCurve(
+		const std::vector<double> &targetDurations_s,
+		const std::vector<double> &furthestPerTarget_m,
+		const std::vector<SegmentCandidate> &bestPerTarget)
+	{
+		std::vector<DurationCurvePoint> bestPerDuration;
+		for (size_t k = 0; k < targetDurations_s.size(); ++k)
+		{
+			if (bestPerTarget[k].valid)
+				bestPerDuration.push_back(DurationCurvePoint(targetDurations_s[k], furthestPerTarget_m[k], bestPerTarget[k].segment));
+		}
+
+		return bestPerDuration;
+	}
+
+	// Merge neighbouring pairs of curves in parallel until one is left
+	// Pairs keep their order, so ties resolve the same as merging the curves one after another
+	std::vector<PaceCurvePoint> reduceIncreasingPaceCurves(
+		std::vector<std::vector<PaceCurvePoint>> paceCurves,
+		const unsigned nThreads)
+	{
+		if (paceCurves.empty())
+			return{};
+
+		while (paceCurves.size() > 1)
+		{
+			std::vector<std::vector<PaceCurvePoint>> merged((paceCurves.size() + 1) / 2);
+			forEachChunkInParallel(paceCurves.size() / 2, nThreads, [&](size_t pair)
+			{
+				merged[pair] = mergeIncreasingPaceCurves(paceCurves[2 * pair], paceCurves[2 * pair + 1]);
+			});
+
+			if (paceCurves.size() % 2 == 1)
+				merged.back() = std::move(paceCurves.back());
+
+			paceCurves = std::move(merged);
+		}
+
+		auto bestPoints = std::move(paceCurves.front());
+		cascadeDownTargets(bestPoints);
+
+		return bestPoints;
+	}
+}
+
+std::vector<PaceCurvePoint> reindeer::calculatePaceCurve(
+	const std::vector<GpxPoint> &gpxData,
+	const double min_m,
+	const double resolution_m,
+	const double minElevationDiff_m,
+	const PaceCurveEngine engine,
+	const unsigned nThreads)
+{
+	if (engine == PaceCurveEngine::PREFIX_SUM)
+		return calculatePaceCurve(ActivityColumns::fromGpx(gpxData), min_m, resolution_m, minElevationDiff_m, nThreads);
+
+	const auto targetDistances = calculateTargetDistances(calculateTotalDistance(gpxData), min_m, resolution_m);
+	return calculatePaceCurveExhaustive(gpxData, targetDistances, minElevationDiff_m, nThreads);
+}
+
+std::vector<PaceCurvePoint> reindeer::calculatePaceCurve(
+	const ActivityColumns &activity,
+	const double min_m,
+	const double resolution_m,
+	const double minElevationDiff_m,
+	const unsigned nThreads)
+{
+	const auto targetDistances = calculateTargetDistances(activity.total().distanceTime.distance_m, min_m, resolution_m);
+	return calculatePaceCurvePrefixSum(activity, targetDistances, minElevationDiff_m, nThreads);
+}
+
+std::vector<PaceCurvePoint> reindeer::calculatePaceCurve(
+	const std::vector<GpxPoint> &gpxData,
+	const std::vector<double> &targetDistances_m,
+	const double minElevationDiff_m,
+	const PaceCurveEngine engine,
+	const unsigned nThreads)
+{
+	if (engine == PaceCurveEngine::PREFIX_SUM)
+		return calculatePaceCurve(ActivityColumns::fromGpx(gpxData), targetDistances_m, minElevationDiff_m, nThreads);
+
+	const auto targetDistances = reachableTargets(targetDistances_m, calculateTotalDistance(gpxData));
+	return calculatePaceCurveExhaustive(gpxData, targetDistances, minElevationDiff_m, nThreads);
+}
+
+std::vector<PaceCurvePoint> reindeer::calculatePaceCurve(
+	const ActivityColumns &activity,
+	const std::vector<double> &targetDistances_m,
+	const double minElevationDiff_m,
+	const unsigned nThreads)
+{
+	const auto targetDistances = reachableTargets(targetDistances_m, activity.total().distanceTime.distance_m);
+	return calculatePaceCurvePrefixSum(activity, targetDistances, minElevationDiff_m, nThreads);
+}
+
+std::vector<double> reindeer::calculateLogSpacedDistances(
+	const double min_m,
+	const double max_m,
+	const unsigned distancesPerDoubling)
+{
+	if (!(min_m > 0.0) || distancesPerDoubling == 0)
+		throw std::invalid_argument("Log spaced distances need a positive minimum and spacing");
+
+	// Calculate each distance from the minimum, rather than by repeated multiplication, so errors don't accumulate
+	std::vector<double> distances_m;
+	for (unsigned i = 0; ; ++i)
+	{
+		const auto distance_m = min_m * std::exp2(static_cast<double>(i) / static_cast<double>(distancesPerDoubling));
+		if (distance_m > max_m)
+			break;
+
+		distances_m.push_back(distance_m);
+	}
+
+	return distances_m;
+}
+
+ApproximatePaceCurve reindeer::calculateApproximatePaceCurve(
+	const ActivityColumns &activity,
+	const double min_m,
+	const double resolution_m,
+	const double maxGapTime_s,
+	const unsigned nThreads)
+{
+	ApproximatePaceCurve approximate;
+	const auto decimated = decimateOnTime(activity, maxGapTime_s);
+	approximate.nPointsUsed = decimated.size();
+
+	const auto targetDistances = calculateTargetDistances(activity.total().distanceTime.distance_m, min_m, resolution_m);
+	approximate.paceCurve = calculatePaceCurvePrefixSum(
+		decimated, targetDistances, -std::numeric_limits<double>::infinity(), nThreads);
+
+	// The best exact segment for distance d, with pace p, lies within a kept segment at most 2 * maxGapTime_s longer
+	// That segment covers d too, so the approximate pace p' >= d / (d / p + 2 * maxGapTime_s)
+	// So p <= d / (d / p' - 2 * maxGapTime_s), and isn't bounded if the kept segment is shorter than 2 * maxGapTime_s
+	for (const auto &point : approximate.paceCurve)
+	{
+		const auto approximatePace = point.bestPaceSegment.distanceTime.pace_ms();
+		const auto minExactTime_s = point.distance_m / approximatePace - 2.0 * maxGapTime_s;
+		const auto maxPaceError = minExactTime_s > 0.0 ?
+			point.distance_m / minExactTime_s - approximatePace :
+			std::numeric_limits<double>::infinity();
+
+		approximate.maxPaceErrors.push_back(maxPaceError);
+		approximate.maxPaceError = std::max(approximate.maxPaceError, maxPaceError);
+	}
+
+	return approximate;
+}
+
+std::vector<std::vector<PaceCurvePoint>> reindeer::calculatePaceCurves(
+	const std::vector<GpxPoint> &gpxData,
+	const double min_m,
+	const double resolution_m,
+	const std::vector<double> &minElevationDiffs_m,
+	const unsigned nThreads)
+{
+	return calculatePaceCurves(ActivityColumns::fromGpx(gpxData), min_m, resolution_m, minElevationDiffs_m, nThreads);
+}
+
+std::vector<std::vector<PaceCurvePoint>> reindeer::calculatePaceCurves(
+	const ActivityColumns &activity,
+	const double min_m,
+	const double resolution_m,
+	const std::vector<double> &minElevationDiffs_m,
+	const unsigned nThreads)
+{
+	if (!std::is_sorted(minElevationDiffs_m.begin(), minElevationDiffs_m.end()))
+		throw std::invalid_argument("Elevation thresholds must be in increasing order");
+
+	const auto targetDistances = calculateTargetDistances(activity.total().distanceTime.distance_m, min_m, resolution_m);
+	return calculatePaceCurvesPrefixSum(activity, targetDistances, minElevationDiffs_m, nThreads);
+}
+
+struct PaceCurveBuilder::Impl
+{
+	Impl(const double min_m, const double resolution_m, const double minElevationDiff_m) :
+		min_m(min_m), resolution_m(resolution_m), minElevationDiff_m(minElevationDiff_m)
+	{
+	}
+
+	const double min_m;
+	const double resolution_m;
+	const double minElevationDiff_m;
+
+	ActivityColumns activity;
+	GpxPoint previousPoint = GpxPoint(0.0, 0.0, 0.0, 0);
+	std::vector<double> targetDistances;
+
+	// While every segment meets the elevation criteria, we search per target
+	bool elevationCriteriaMet = true;
+	double highestElevationSoFar_m = 0.0;
+	std::vector<BestSegmentSearch> searches;
+
+	// Otherwise keep the best segment for the largest target each segment covers
+	std::vector<SegmentCandidate> bestPerLargestTarget;
+
+	void append(const GpxPoint &point)
+	{
+		activity.append(activity.size() > 0 ? DistTimeElev::fromGpx(previousPoint, point) : DistTimeElev::zero());
+		previousPoint = point;
+
+		const auto to = activity.size() - 1;
+
+		addReachedTargets();
+		updateElevationCriteria(to);
+
+		if (elevationCriteriaMet)
+		{
+			for (auto &search : searches)
+				search.addEndPoint(activity, to);
+		}
+		else
+		{
+			addSegmentsEndingAt(activity, to, targetDistances, minElevationDiff_m, DISTANCE_AXIS, bestPerLargestTarget);
+		}
+	}
+
+	std::vector<PaceCurvePoint> current() const
+	{
+		if (elevationCriteriaMet)
+		{
+			const auto bestPerTarget = convertAll<SegmentCandidate>(searches, [](const BestSegmentSearch &search) {
+				return search.bestSegment();
+			});
+
+			return toPaceCurve(targetDistances, bestPerTarget);
+		}
+
+		return toPaceCurve(targetDistances, cascadeToShorterTargets(bestPerLargestTarget));
+	}
+
+private:
+
+	// Add target distances up to the total distance so far
+	// No previous segment can cover a new target, so the new searches start empty
+	void addReachedTargets()
+	{
+		const auto totalDistance_m = activity.total().distanceTime.distance_m;
+		for (;;)
+		{
+			const auto distance_m = min_m + resolution_m * static_cast<double>(targetDistances.size());
+			if (distance_m > totalDistance_m)
+				break;
+
+			targetDistances.push_back(distance_m);
+			searches.push_back(BestSegmentSearch(distance_m, DISTANCE_AXIS));
+			bestPerLargestTarget.push_back(SegmentCandidate());
+		}
+	}
+
+	void updateElevationCriteria(const size_t to)
+	{
+		const auto elevation_m = activity.elevationDiff_m[to];
+		if (to == 0)
+		{
+			highestElevationSoFar_m = elevation_m;
+			return;
+		}
+
+		// The smallest diff ending at this point is from the highest point before it
+		if (elevationCriteriaMet && elevation_m - highestElevationSoFar_m < minElevationDiff_m)
+		{
+			// Switch to checking all segments, catching up on the points we already have - O(n^2 log k) once
+			elevationCriteriaMet = false;
+			searches.clear();
+			for (size_t previousTo = 1; previousTo < to; ++previousTo)
+				addSegmentsEndingAt(activity, previousTo, targetDistances, minElevationDiff_m, DISTANCE_AXIS, bestPerLargestTarget);
+		}
+
+		highestElevationSoFar_m = std::max(highestElevationSoFar_m, elevation_m);
+	}
+};
+
+PaceCurveBuilder::PaceCurveBuilder(const double min_m, const double resolution_m, const double minElevationDiff_m) :
+	impl(std::make_unique<Impl>(min_m, resolution_m, minElevationDiff_m))
+{
+}
+
+PaceCurveBuilder::~PaceCurveBuilder() = default;
+
+void PaceCurveBuilder::append(const GpxPoint &point)
+{
+	impl->append(point);
+}
+
+std::vector<PaceCurvePoint> PaceCurveBuilder::current() const
+{
+	return impl->current();
+}
+
+size_t PaceCurveBuilder::pointCount() const
+{
+	return impl->activity.size();
+}
+
+std::vector<PaceCurvePoint> reindeer::mergePaceCurves(const std::vector<std::vector<PaceCurvePoint>> &paceCurves)
+{
+	return mergeCurves(paceCurves, &PaceCurvePoint::distance_m);
+}
+
+std::vector<PaceCurvePoint> reindeer::mergePaceCurvesParallel(
+	const std::vector<std::vector<PaceCurvePoint>> &paceCurves,
+	const unsigned nThreads)
+{
+	std::vector<std::vector<PaceCurvePoint>> increasingCurves(paceCurves.size());
+	forEachChunkInParallel(paceCurves.size(), nThreads, [&](size_t c)
+	{
+		increasingCurves[c] = toIncreasingDistances(paceCurves[c]);
 	});
 
-	// Cascade down distances (if we have a shorter distance with a worse pace, replace with the higher distance)
-	for (size_t i = 1; i < bestPoints.size(); ++i)
+	return reduceIncreasingPaceCurves(std::move(increasingCurves), nThreads);
+}
+
+std::vector<PaceCurvePoint> reindeer::calculateMergedPaceCurve(
+	const std::vector<std::vector<GpxPoint>> &activities,
+	const double min_m,
+	const double resolution_m,
+	const double minElevationDiff_m,
+	const unsigned nThreads)
+{
+	// Each activity is calculated on a single thread, we parallelise across activities
+	// Pace curves already have increasing distances
+	std::vector<std::vector<PaceCurvePoint>> paceCurves(activities.size());
+	forEachChunkInParallel(activities.size(), nThreads, [&](size_t a)
 	{
-		const auto reverseIndex = bestPoints.size() - 1 - i;
-		auto &currentPoint = bestPoints[reverseIndex];
-		const auto &bestWithHigherDistance = bestPoints[reverseIndex + 1].bestPaceSegment;
-		if (isImprovement(currentPoint.bestPaceSegment, bestWithHigherDistance))
+		paceCurves[a] = calculatePaceCurve(ActivityColumns::fromGpx(activities[a]), min_m, resolution_m, minElevationDiff_m);
+	});
+
+	return reduceIncreasingPaceCurves(std::move(paceCurves), nThreads);
+}
+
+std::vector<DurationCurvePoint> reindeer::calculateDurationCurve(
+	const std::vector<GpxPoint> &gpxData,
+	const std::vector<double> &targetDurations_s,
+	const double minElevationDiff_m,
+	const unsigned nThreads)
+{
+	return calculateDurationCurve(ActivityColumns::fromGpx(gpxData), targetDurations_s, minElevationDiff_m, nThreads);
+}
+
+std::vector<DurationCurvePoint> reindeer::calculateDurationCurve(
+	const ActivityColumns &activity,
+	const std::vector<double> &targetDurations_s,
+	const double minElevationDiff_m,
+	const unsigned nThreads)
+{
+	const auto targets = reachableTargets(targetDurations_s, activity.total().distanceTime.time_s);
+	return toDurationCurve(targets,
+		findFurthestDistances(activity, targets, minElevationDiff_m, nThreads),
+		findBestSegmentsPrefixSum(activity, targets, minElevationDiff_m, TIME_AXIS, nThreads));
+}
+
+std::vector<BestEffortsPoint> reindeer::calculateBestEfforts(
+	const std::vector<GpxPoint> &gpxData,
+	const std::vector<double> &targetDistances_m,
+	const double minElevationDiff_m,
+	const size_t maxEfforts,
+	const unsigned nThreads)
+{
+	return calculateBestEfforts(ActivityColumns::fromGpx(gpxData), targetDistances_m, minElevationDiff_m, maxEfforts, nThreads);
+}
+
+std::vector<BestEffortsPoint> reindeer::calculateBestEfforts(
+	const ActivityColumns &activity,
+	const std::vector<double> &targetDistances_m,
+	const double minElevationDiff_m,
+	const size_t maxEfforts,
+	const unsigned nThreads)
+{
+	const auto targetDistances = reachableTargets(targetDistances_m, activity.total().distanceTime.distance_m);
+	const auto elevationCriteriaMet = elevationCriteriaAlwaysMet(activity, minElevationDiff_m);
+
+	// Each target is independent
+	std::vector<BestEffortsPoint> bestEffortsPerDistance(targetDistances.size());
+	forEachChunkInParallel(targetDistances.size(), nThreads, [&](size_t k)
+	{
+		bestEffortsPerDistance[k].distance_m = targetDistances[k];
+		bestEffortsPerDistance[k].efforts = findBestEfforts(
+			activity, targetDistances[k], minElevationDiff_m, elevationCriteriaMet, maxEfforts);
+	});
+
+	bestEffortsPerDistance.erase(std::remove_if(bestEffortsPerDistance.begin(), bestEffortsPerDistance.end(),
+		[](const BestEffortsPoint &p) { return p.efforts.empty(); }), bestEffortsPerDistance.end());
+
+	return bestEffortsPerDistance;
+}
+
+std::vector<DurationCurvePoint> reindeer::mergeDurationCurves(const std::vector<std::vector<DurationCurvePoint>> &durationCurves)
+{
+	std::map<double, double> durationToFurthest_m;
+	for (const auto &curve : durationCurves)
+	{
+		for (const auto &p : curve)
 		{
-			currentPoint.bestPaceSegment = bestWithHigherDistance;
+			auto &furthest_m = durationToFurthest_m[p.duration_s];
+			furthest_m = std::max(furthest_m, p.distance_m);
 		}
 	}
 
-	return bestPoints;
+	// The furthest distance needn't come from the curve with the best pace
+	auto merged = mergeCurves(durationCurves, &DurationCurvePoint::duration_s);
+	auto furthest_m = 0.0;
+	for (auto &p : merged)
+	{
+		furthest_m = std::max(furthest_m, durationToFurthest_m[p.duration_s]);
+		p.distance_m = furthest_m;
+	}
+
+	return merged;
 }
\ No newline at end of file
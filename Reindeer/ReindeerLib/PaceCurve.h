@@ -1,7 +1,9 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "ActivityColumns.h"
 #include "ActivityStructures.h"
 
 namespace reindeer
@@ -19,11 +21,210 @@ namespace reindeer
 		}
 	};
 
+	// The dual of PaceCurvePoint, the best pace over a segment lasting at least duration_s
+	// distance_m is the furthest covered by a segment lasting at most duration_s (0 if no segment meets the elevation criteria)
+	struct DurationCurvePoint
+	{
+		double duration_s = 0.0;
+		double distance_m = 0.0;
+		DistTimeElev bestPaceSegment = DistTimeElev::zero();
+
+		DurationCurvePoint() = default;
+
+		DurationCurvePoint(double duration_s, double distance_m, DistTimeElev bestPaceSegment) :
+			duration_s(duration_s), distance_m(distance_m), bestPaceSegment(bestPaceSegment)
+		{
+		}
+	};
+
+	// A segment and where it is in the activity, as gpx point indices
+	struct LocatedSegment
+	{
+		DistTimeElev segment = DistTimeElev::zero();
+		size_t fromIndex = 0;
+		size_t toIndex = 0;
+
+		LocatedSegment() = default;
+
+		LocatedSegment(DistTimeElev segment, size_t fromIndex, size_t toIndex) :
+			segment(segment), fromIndex(fromIndex), toIndex(toIndex)
+		{
+		}
+	};
+
+	// The best non-overlapping segments covering at least distance_m, best first
+	struct BestEffortsPoint
+	{
+		double distance_m = 0.0;
+		std::vector<LocatedSegment> efforts;
+	};
+
+	enum class PaceCurveEngine
+	{
+		// Walks every sub-segment and checks it against every target distance - O(n^2 * k)
+		EXHAUSTIVE,
+		// Uses prefix sums of distance/time with a monotone window per target distance
+		// Gives the same output as EXHAUSTIVE (up to floating point rounding of the segment sums)
+		// Expects strictly increasing timestamps
+		PREFIX_SUM
+	};
+
+	// nThreads splits the work across threads (0 uses all hardware threads)
+	// The output is the same for any number of threads
 	std::vector<PaceCurvePoint> calculatePaceCurve(
 		const std::vector<GpxPoint> &gpxData, 
 		const double min_m, 
 		const double resolution_m,
-		const double minElevationDiff_m);
+		const double minElevationDiff_m,
+		const PaceCurveEngine engine = PaceCurveEngine::EXHAUSTIVE,
+		const unsigned nThreads = 1);
+
+	// Uses PaceCurveEngine::PREFIX_SUM on an activity that's already in columns
+	std::vector<PaceCurvePoint> calculatePaceCurve(
+		const ActivityColumns &activity,
+		const double min_m,
+		const double resolution_m,
+		const double minElevationDiff_m,
+		const unsigned nThreads = 1);
+
+	// Pace curve over any sorted grid of target distances (e.g. log spaced, or standard race distances)
+	// Each segment binary searches the grid, so the run time scales with the grid size rather than resolution
+	// Targets beyond the total distance are dropped
+	// Throws std::invalid_argument if targetDistances_m isn't in increasing order
+	std::vector<PaceCurvePoint> calculatePaceCurve(
+		const std::vector<GpxPoint> &gpxData,
+		const std::vector<double> &targetDistances_m,
+		const double minElevationDiff_m,
+		const PaceCurveEngine engine = PaceCurveEngine::EXHAUSTIVE,
+		const unsigned nThreads = 1);
+
+	std::vector<PaceCurvePoint> calculatePaceCurve(
+		const ActivityColumns &activity,
+		const std::vector<double> &targetDistances_m,
+		const double minElevationDiff_m,
+		const unsigned nThreads = 1);
+
+	// Distances from min_m up to max_m, with a fixed ratio between consecutive distances
+	std::vector<double> calculateLogSpacedDistances(
+		const double min_m,
+		const double max_m,
+		const unsigned distancesPerDoubling);
+
+	struct ApproximatePaceCurve
+	{
+		std::vector<PaceCurvePoint> paceCurve;
+
+		// The exact pace at each distance is no faster than the approximate pace plus this (and no slower than the approximate pace)
+		// Infinite where the approximate segment is too short for a bound
+		std::vector<double> maxPaceErrors;
+		double maxPaceError = 0.0;
+
+		size_t nPointsUsed = 0;
+	};
+
+	// Quick pace curve for very long activities (e.g. for a preview while the exact curve is calculated)
+	// Drops points so that consecutive points are at most maxGapTime_s apart (where the original allows), keeping their running totals
+	// Each reported segment is real, but the best segment may start and end up to maxGapTime_s away from the kept points
+	// The elevation criteria isn't applied, as widening a segment changes its elevation diff
+	ApproximatePaceCurve calculateApproximatePaceCurve(
+		const ActivityColumns &activity,
+		const double min_m,
+		const double resolution_m,
+		const double maxGapTime_s,
+		const unsigned nThreads = 1);
+
+	// One pace curve per elevation threshold, each the same as calculatePaceCurve with that minElevationDiff_m
+	// Every sub-segment is visited once for all the thresholds, rather than once per threshold
+	// Throws std::invalid_argument if minElevationDiffs_m isn't in increasing order
+	std::vector<std::vector<PaceCurvePoint>> calculatePaceCurves(
+		const std::vector<GpxPoint> &gpxData,
+		const double min_m,
+		const double resolution_m,
+		const std::vector<double> &minElevationDiffs_m,
+		const unsigned nThreads = 1);
+
+	std::vector<std::vector<PaceCurvePoint>> calculatePaceCurves(
+		const ActivityColumns &activity,
+		const double min_m,
+		const double resolution_m,
+		const std::vector<double> &minElevationDiffs_m,
+		const unsigned nThreads = 1);
+
+	// Builds a pace curve as gpx points arrive (e.g. from a live activity)
+	// Each append only considers segments ending at the new point - amortised O(k log n) per point, for the k targets reached so far
+	// (each target binary searches a hull of start points, as the best start can move either way when a point arrives)
+	// If the elevation criteria ever excludes a segment, catches up by checking every segment so far - O(n^2 log k) once
+	// After that, each append checks every segment ending at the new point - O(n log k) per point
+	// current() gives the same output as calculatePaceCurve with PaceCurveEngine::PREFIX_SUM on the points so far
+	class PaceCurveBuilder
+	{
+	public:
+		PaceCurveBuilder(const double min_m, const double resolution_m, const double minElevationDiff_m);
+		~PaceCurveBuilder();
+
+		void append(const GpxPoint &point);
+		std::vector<PaceCurvePoint> current() const;
+
+		size_t pointCount() const;
+
+	private:
+		struct Impl;
+		const std::unique_ptr<Impl> impl;
+	};
 
 	std::vector<PaceCurvePoint> mergePaceCurves(const std::vector<std::vector<PaceCurvePoint>> &paceCurves);
+
+	// Duration curve over a sorted grid of target durations (e.g. 1s, 5s, ... 5h)
+	// Uses the same prefix sum search as PaceCurveEngine::PREFIX_SUM, with the targets on time rather than distance
+	// The furthest distances are a sliding window over time when the elevation criteria can't exclude anything, O(n) per target
+	// Throws std::invalid_argument if targetDurations_s isn't in increasing order
+	std::vector<DurationCurvePoint> calculateDurationCurve(
+		const std::vector<GpxPoint> &gpxData,
+		const std::vector<double> &targetDurations_s,
+		const double minElevationDiff_m,
+		const unsigned nThreads = 1);
+
+	std::vector<DurationCurvePoint> calculateDurationCurve(
+		const ActivityColumns &activity,
+		const std::vector<double> &targetDurations_s,
+		const double minElevationDiff_m,
+		const unsigned nThreads = 1);
+
+	// Up to maxEfforts segments for each target distance, with their locations (e.g. the 3 best 5km efforts)
+	// The first effort is the pace curve's segment, each next one is the best that doesn't overlap those before it
+	// Efforts may share an end point
+	// Each effort only searches the gaps the previous one split - O(k * maxEfforts * n log n), or O(k * n^2) if the elevation criteria excludes segments
+	// Targets with no efforts are dropped
+	// Throws std::invalid_argument if targetDistances_m isn't in increasing order
+	std::vector<BestEffortsPoint> calculateBestEfforts(
+		const std::vector<GpxPoint> &gpxData,
+		const std::vector<double> &targetDistances_m,
+		const double minElevationDiff_m,
+		const size_t maxEfforts,
+		const unsigned nThreads = 1);
+
+	std::vector<BestEffortsPoint> calculateBestEfforts(
+		const ActivityColumns &activity,
+		const std::vector<double> &targetDistances_m,
+		const double minElevationDiff_m,
+		const size_t maxEfforts,
+		const unsigned nThreads = 1);
+
+	// As mergePaceCurves, for duration curves
+	// Each distance_m is the furthest of any curve for that duration or a shorter one
+	std::vector<DurationCurvePoint> mergeDurationCurves(const std::vector<std::vector<DurationCurvePoint>> &durationCurves);
+
+	// Same output as mergePaceCurves, but merges pairs of curves as sorted arrays in parallel rather than through a map
+	std::vector<PaceCurvePoint> mergePaceCurvesParallel(
+		const std::vector<std::vector<PaceCurvePoint>> &paceCurves,
+		const unsigned nThreads = 0);
+
+	// Calculates the pace curve of each activity (in parallel) and merges them
+	// Same output as mergePaceCurves on the individual pace curves
+	std::vector<PaceCurvePoint> calculateMergedPaceCurve(
+		const std::vector<std::vector<GpxPoint>> &activities,
+		const double min_m,
+		const double resolution_m,
+		const double minElevationDiff_m,
+		const unsigned nThreads = 0);
 }
\ No newline at end of file
@@ -0,0 +1,408 @@
+#include "PaceCurveCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <tuple>
+
+#include "StdThreadSupportWrappers.h"
+
+#include "ActivityColumns.h"
+#include "MemoryMappedFile.h"
+
+using namespace reindeer;
+
+namespace
+{
+	// File layout: FileHeader, EntryHeader[nEntries], then every entry's PaceCurveRecords
+	constexpr uint64_t CACHE_FILE_MAGIC = 0x5043434E49455244; // "DREINCCP"
+	// Version 2: segment times are in seconds (version 1 curves were 1e6 times too large)
+	constexpr uint64_t CACHE_FILE_VERSION = 2;
+
+	struct FileHeader
+	{
+		uint64_t magic;
+		uint64_t version;
+		uint64_t nEntries;
+	};
+
+	struct EntryHeader
+	{
+		uint64_t contentHash;
+		uint64_t nPoints;
+		double min_m;
+		double resolution_m;
+		double minElevationDiff_m;
+		uint64_t lastUsed;
+		uint64_t firstRecord;
+		uint64_t nRecords;
+	};
+
+	struct PaceCurveRecord
+	{
+		double distance_m;
+		double segmentDistance_m;
+		double segmentTime_s;
+		double elevationDiff_m;
+		double cumulativeElevation_m;
+	};
+
+	struct CacheKey
+	{
+		uint64_t contentHash;
+		uint64_t nPoints;
+		double min_m;
+		double resolution_m;
+		double minElevationDiff_m;
+
+		bool operator<(const CacheKey &o) const
+		{
+			return std::tie(contentHash, nPoints, min_m, resolution_m, minElevationDiff_m) <
+				std::tie(o.contentHash, o.nPoints, o.min_m, o.resolution_m, o.minElevationDiff_m);
+		}
+	};
+
+	// FNV-1a style hash, a 64 bit word at a time
+	uint64_t hashGpxData(const std::vector<GpxPoint> &gpxData)
+	{
+		constexpr uint64_t offsetBasis = 14695981039346656037ULL;
+		constexpr uint64_t prime = 1099511628211ULL;
+
+		const auto hashWord = [prime](uint64_t hash, uint64_t word)
+		{
+			return (hash ^ word) * prime;
+		};
+
+		const auto asWord = [](double d)
+		{
+			uint64_t word;
+			std::memcpy(&word, &d, sizeof(word));
+			return word;
+		};
+
+		auto hash = offsetBasis;
+		for (const auto &p : gpxData)
+		{
+			hash = hashWord(hash, asWord(p.longitude));
+			hash = hashWord(hash, asWord(p.latitude));
+			hash = hashWord(hash, asWord(p.elevation_m));
+			hash = hashWord(hash, p.dateTime_ms);
+		}
+
+		return hash;
+	}
+
+	PaceCurveRecord toRecord(const PaceCurvePoint &p)
+	{
+		return { p.distance_m,
+			p.bestPaceSegment.distanceTime.distance_m,
+			p.bestPaceSegment.distanceTime.time_s,
+			p.bestPaceSegment.elevation.elevationDiff_m,
+			p.bestPaceSegment.elevation.cumulativeElevation_m };
+	}
+
+	PaceCurvePoint fromRecord(const PaceCurveRecord &r)
+	{
+		return PaceCurvePoint(r.distance_m, DistTimeElev(
+			DistanceTime(r.segmentDistance_m, r.segmentTime_s),
+			ElevationInfo(r.elevationDiff_m, r.cumulativeElevation_m)));
+	}
+
+	size_t entrySize_bytes(size_t nRecords)
+	{
+		return sizeof(EntryHeader) + nRecords * sizeof(PaceCurveRecord);
+	}
+}
+
+struct PaceCurveCache::Impl
+{
+	Impl(const std::wstring &path, size_t maxFileSize_bytes) :
+		path(path), maxFileSize_bytes(maxFileSize_bytes)
+	{
+		openCacheFile();
+	}
+
+	// An entry is either in the mapped file or added since the last flush
+	struct Entry
+	{
+		uint64_t lastUsed = 0;
+		const PaceCurveRecord *mappedRecords = nullptr;
+		size_t nRecords = 0;
+		std::vector<PaceCurvePoint> addedPaceCurve;
+	};
+
+	const std::wstring path;
+	const size_t maxFileSize_bytes;
+
+	mutable obelisk::Mutex mutex;
+	std::unique_ptr<MemoryMappedFile> mappedFile;
+	std::map<CacheKey, Entry> entries;
+	uint64_t useCounter = 0;
+	bool hasChanges = false;
+	size_t nHits = 0;
+	size_t nMisses = 0;
+
+	// Returns false if there's no entry for the key
+	bool find(const CacheKey &key, std::vector<PaceCurvePoint> &paceCurve)
+	{
+		obelisk::LockGuard lk(mutex);
+
+		const auto it = entries.find(key);
+		if (it == entries.end())
+		{
+			++nMisses;
+			return false;
+		}
+
+		auto &entry = it->second;
+		if (entry.mappedRecords)
+		{
+			paceCurve.clear();
+			paceCurve.reserve(entry.nRecords);
+			for (size_t i = 0; i < entry.nRecords; ++i)
+				paceCurve.push_back(fromRecord(entry.mappedRecords[i]));
+		}
+		else
+		{
+			paceCurve = entry.addedPaceCurve;
+		}
+
+		// Not a change on its own, the usage order is saved with the next new entries
+		entry.lastUsed = ++useCounter;
+		++nHits;
+		return true;
+	}
+
+	void add(const CacheKey &key, const std::vector<PaceCurvePoint> &paceCurve)
+	{
+		obelisk::LockGuard lk(mutex);
+
+		Entry entry;
+		entry.lastUsed = ++useCounter;
+		entry.nRecords = paceCurve.size();
+		entry.addedPaceCurve = paceCurve;
+		entries[key] = std::move(entry);
+		hasChanges = true;
+	}
+
+	void flush()
+	{
+		obelisk::LockGuard lk(mutex);
+
+		if (!hasChanges)
+			return;
+
+		// Keep the most recently used entries that fit
+		std::vector<std::map<CacheKey, Entry>::const_iterator> kept;
+		for (auto it = entries.cbegin(); it != entries.cend(); ++it)
+			kept.push_back(it);
+
+		std::sort(kept.begin(), kept.end(), [](const auto &a, const auto &b) {
+			return a->second.lastUsed > b->second.lastUsed;
+		});
+
+		auto fileSize_bytes = sizeof(FileHeader);
+		kept.erase(std::remove_if(kept.begin(), kept.end(), [&fileSize_bytes, this](const auto &it) {
+			const auto size_bytes = entrySize_bytes(it->second.nRecords);
+			if (fileSize_bytes + size_bytes > maxFileSize_bytes)
+				return true;
+
+			fileSize_bytes += size_bytes;
+			return false;
+		}), kept.end());
+
+		// Write to a temporary file (reading from the current mapping) and then replace
+		// The temporary file is removed if anything fails, so it isn't left beside the cache
+		const auto tempPath = std::filesystem::path(path + L".tmp");
+		std::error_code ec;
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (!out)
+			{
+				std::filesystem::remove(tempPath, ec);
+				throw std::runtime_error("Failed to open pace curve cache file for writing");
+			}
+
+			const FileHeader fileHeader = { CACHE_FILE_MAGIC, CACHE_FILE_VERSION, kept.size() };
+			out.write(reinterpret_cast<const char *>(&fileHeader), sizeof(fileHeader));
+
+			uint64_t firstRecord = 0;
+			for (const auto &it : kept)
+			{
+				const auto &key = it->first;
+				const auto &entry = it->second;
+				const EntryHeader entryHeader = { key.contentHash, key.nPoints, key.min_m, key.resolution_m, key.minElevationDiff_m,
+					entry.lastUsed, firstRecord, entry.nRecords };
+				out.write(reinterpret_cast<const char *>(&entryHeader), sizeof(entryHeader));
+				firstRecord += entry.nRecords;
+			}
+
+			for (const auto &it : kept)
+			{
+				const auto &entry = it->second;
+				if (entry.mappedRecords)
+				{
+					out.write(reinterpret_cast<const char *>(entry.mappedRecords), entry.nRecords * sizeof(PaceCurveRecord));
+				}
+				else
+				{
+					for (const auto &p : entry.addedPaceCurve)
+					{
+						const auto record = toRecord(p);
+						out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+					}
+				}
+			}
+
+			if (!out)
+			{
+				out.close();
+				std::filesystem::remove(tempPath, ec);
+				throw std::runtime_error("Failed to write pace curve cache file");
+			}
+		}
+
+		// The mapping must be released before the file can be replaced
+		// Entries that aren't in the file yet are set aside, so they aren't lost if it can't be replaced
+		std::map<CacheKey, Entry> added;
+		for (auto &keyEntry : entries)
+		{
+			if (!keyEntry.second.mappedRecords)
+				added.insert(std::move(keyEntry));
+		}
+
+		entries.clear();
+		mappedFile.reset();
+
+		std::filesystem::rename(tempPath, std::filesystem::path(path), ec);
+		openCacheFile();
+
+		if (ec)
+		{
+			std::filesystem::remove(tempPath, ec);
+			for (auto &keyEntry : added)
+				entries[keyEntry.first] = std::move(keyEntry.second);
+
+			hasChanges = !added.empty();
+			throw std::runtime_error("Failed to replace pace curve cache file");
+		}
+	}
+
+private:
+
+	void openCacheFile()
+	{
+		entries.clear();
+		hasChanges = false;
+
+		std::error_code ec;
+		if (!std::filesystem::exists(std::filesystem::path(path), ec))
+			return;
+
+		try
+		{
+			mappedFile = std::make_unique<MemoryMappedFile>(path);
+		}
+		catch (const std::runtime_error &)
+		{
+			return;
+		}
+
+		const auto data = mappedFile->data();
+		const auto size = mappedFile->size();
+
+		// Ignore files that aren't valid
+		FileHeader fileHeader;
+		if (size < sizeof(fileHeader))
+			return;
+
+		std::memcpy(&fileHeader, data, sizeof(fileHeader));
+		if (fileHeader.magic != CACHE_FILE_MAGIC ||
+			fileHeader.version != CACHE_FILE_VERSION ||
+			fileHeader.nEntries > (size - sizeof(FileHeader)) / sizeof(EntryHeader))
+			return;
+
+		const auto entryHeaders = reinterpret_cast<const EntryHeader *>(data + sizeof(FileHeader));
+		const auto recordsOffset = sizeof(FileHeader) + fileHeader.nEntries * sizeof(EntryHeader);
+		const auto records = reinterpret_cast<const PaceCurveRecord *>(data + recordsOffset);
+		const auto nRecordsInFile = (size - recordsOffset) / sizeof(PaceCurveRecord);
+
+		for (size_t i = 0; i < fileHeader.nEntries; ++i)
+		{
+			const auto &header = entryHeaders[i];
+			if (header.firstRecord > nRecordsInFile || header.nRecords > nRecordsInFile - header.firstRecord)
+			{
+				entries.clear();
+				return;
+			}
+
+			const CacheKey key = { header.contentHash, header.nPoints, header.min_m, header.resolution_m, header.minElevationDiff_m };
+			Entry entry;
+			entry.lastUsed = header.lastUsed;
+			entry.mappedRecords = records + header.firstRecord;
+			entry.nRecords = header.nRecords;
+			entries[key] = std::move(entry);
+
+			useCounter = std::max(useCounter, header.lastUsed);
+		}
+	}
+};
+
+PaceCurveCache::PaceCurveCache(const std::wstring &path, size_t maxFileSize_bytes) :
+	impl(std::make_unique<Impl>(path, maxFileSize_bytes))
+{
+}
+
+PaceCurveCache::~PaceCurveCache()
+{
+	try
+	{
+		impl->flush();
+	}
+	catch (const std::exception &)
+	{
+	}
+}
+
+std::vector<PaceCurvePoint> PaceCurveCache::calculatePaceCurve(
+	const std::vector<GpxPoint> &gpxData,
+	const double min_m,
+	const double resolution_m,
+	const double minElevationDiff_m)
+{
+	const CacheKey key = { hashGpxData(gpxData), gpxData.size(), min_m, resolution_m, minElevationDiff_m };
+
+	std::vector<PaceCurvePoint> paceCurve;
+	if (impl->find(key, paceCurve))
+		return paceCurve;
+
+	paceCurve = reindeer::calculatePaceCurve(ActivityColumns::fromGpx(gpxData), min_m, resolution_m, minElevationDiff_m);
+	impl->add(key, paceCurve);
+
+	return paceCurve;
+}
+
+void PaceCurveCache::flush()
+{
+	impl->flush();
+}
+
+size_t PaceCurveCache::entryCount() const
+{
+	obelisk::LockGuard lk(impl->mutex);
+	return impl->entries.size();
+}
+
+size_t PaceCurveCache::hitCount() const
+{
+	obelisk::LockGuard lk(impl->mutex);
+	return impl->nHits;
+}
+
+size_t PaceCurveCache::missCount() const
+{
+	obelisk::LockGuard lk(impl->mutex);
+	return impl->nMisses;
+}
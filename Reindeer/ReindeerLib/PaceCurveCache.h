@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ActivityStructures.h"
+#include "PaceCurve.h"
+
+namespace reindeer
+{
+	// Persistent cache in front of calculatePaceCurve
+	// Entries are keyed on a hash of the gpx data and the pace curve parameters
+	// The cache file is memory mapped, so a warm lookup only reads the pages holding that entry
+	// New entries are written by flush(), which evicts the least recently used entries to stay within maxFileSize_bytes
+	// Thread-safe
+	class PaceCurveCache
+	{
+	public:
+		// Starts empty if the file doesn't exist or isn't a valid cache file
+		PaceCurveCache(const std::wstring &path, size_t maxFileSize_bytes);
+
+		// Flushes any changes (errors are ignored, the entries will be recalculated next time)
+		~PaceCurveCache();
+
+		// Returns the cached pace curve, or calculates and caches it
+		std::vector<PaceCurvePoint> calculatePaceCurve(
+			const std::vector<GpxPoint> &gpxData,
+			const double min_m,
+			const double resolution_m,
+			const double minElevationDiff_m);
+
+		// Writes the cache file if there are new entries (hits alone only change the usage order, which is saved with them)
+		// Throws std::runtime_error on failure, keeping the new entries to write next time
+		void flush();
+
+		size_t entryCount() const;
+		size_t hitCount() const;
+		size_t missCount() const;
+
+	private:
+		struct Impl;
+		const std::unique_ptr<Impl> impl;
+	};
+}
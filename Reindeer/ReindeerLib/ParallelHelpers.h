@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace reindeer
+{
+	// A thread count of 0 means use all hardware threads
+	inline unsigned resolveThreadCount(const unsigned nThreads)
+	{
+		if (nThreads != 0)
+			return nThreads;
+
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// The number of threads forEachChunkInParallel uses (including the calling thread)
+	inline size_t parallelWorkerCount(const size_t nChunks, const unsigned nThreads)
+	{
+		return std::min<size_t>(resolveThreadCount(nThreads), nChunks);
+	}
+
+	// Calls fn(chunkIndex, workerIndex) for every chunk in [0, nChunks) using up to nThreads threads (including the calling thread)
+	// workerIndex is in [0, parallelWorkerCount) and is the same for every chunk done by one thread (e.g. for per-thread totals)
+	// Chunks are handed out in order as threads become free, so uneven chunks still balance
+	template <typename Fn>
+	void forEachChunkInParallelOnWorkers(const size_t nChunks, const unsigned nThreads, Fn fn)
+	{
+		const auto nWorkers = parallelWorkerCount(nChunks, nThreads);
+		if (nWorkers <= 1)
+		{
+			for (size_t c = 0; c < nChunks; ++c)
+				fn(c, size_t(0));
+			return;
+		}
+
+		std::atomic<size_t> nextChunk{ 0 };
+		const auto worker = [&nextChunk, nChunks, &fn](size_t workerIndex)
+		{
+			for (auto c = nextChunk++; c < nChunks; c = nextChunk++)
+				fn(c, workerIndex);
+		};
+
+		std::vector<std::future<void>> workers;
+		for (size_t i = 1; i < nWorkers; ++i)
+			workers.push_back(std::async(std::launch::async, worker, i));
+
+		worker(0);
+
+		for (auto &w : workers)
+			w.get();
+	}
+
+	// Calls fn(chunkIndex) for every chunk in [0, nChunks) using up to nThreads threads (including the calling thread)
+	template <typename Fn>
+	void forEachChunkInParallel(const size_t nChunks, const unsigned nThreads, Fn fn)
+	{
+		forEachChunkInParallelOnWorkers(nChunks, nThreads, [&fn](size_t c, size_t)
+		{
+			fn(c);
+		});
+	}
+}
@@ -0,0 +1,511 @@
+#include "PhiloxRandom.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <intrin.h>
+#include <iterator>
+
+using namespace reindeer;
+
+namespace
+{
+	// Philox4x32-10 constants
+	constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+	constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+	constexpr uint32_t PHILOX_W0 = 0x9E3779B9;
+	constexpr uint32_t PHILOX_W1 = 0xBB67AE85;
+	constexpr int PHILOX_ROUNDS = 10;
+
+	// Uniform values use the top 24 bits of a word, which convert to float exactly
+	constexpr int UNIFORM_SHIFT = 8;
+	constexpr float UNIFORM_SCALE = 1.f / 16777216.f;
+
+	// Angles are split into a quarter turn (the top 2 bits, rounded) and the rest, in [-1/8, 1/8) of a turn
+	// Both are exact in integers, so sin and cos only need polynomials on [-pi/4, pi/4)
+	constexpr int QUARTER_TURN_SHIFT = 22;
+	constexpr int32_t HALF_QUARTER_TURN = 1 << (QUARTER_TURN_SHIFT - 1);
+	constexpr float RADIANS_PER_STEP = static_cast<float>(1.5707963267948966 / 4194304.0);
+
+	// Cephes logf, sinf and cosf polynomials
+	constexpr float SQRT_HALF = 0.707106781186547524f;
+	constexpr float LOG_P[] = {
+		7.0376836292E-2f, -1.1514610310E-1f, 1.1676998740E-1f, -1.2420140846E-1f, 1.4249322787E-1f,
+		-1.6668057665E-1f, 2.0000714765E-1f, -2.4999993993E-1f, 3.3333331174E-1f };
+	constexpr float LOG_Q1 = -2.12194440E-4f;
+	constexpr float LOG_Q2 = 0.693359375f;
+	constexpr float SIN_P[] = { -1.9515295891E-4f, 8.3321608736E-3f, -1.6666654611E-1f };
+	constexpr float COS_P[] = { 2.443315711809948E-5f, -1.388731625493765E-3f, 4.166664568298827E-2f };
+
+	// Scalar kernels, and the steps the SIMD kernels follow lane by lane
+
+	// x must be positive and normal
+	float logScalar(const float x)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &x, sizeof(bits));
+
+		// x = m * 2^e with m in [sqrt(0.5), sqrt(2))
+		auto e = static_cast<int32_t>(bits >> 23) - 126;
+		const uint32_t mantissaBits = (bits & 0x007FFFFF) | 0x3F000000;
+		float m;
+		std::memcpy(&m, &mantissaBits, sizeof(m));
+
+		auto t = m - 1.f;
+		if (m < SQRT_HALF)
+		{
+			e -= 1;
+			t = t + m;
+		}
+
+		const auto t2 = t * t;
+		auto y = LOG_P[0];
+		for (size_t i = 1; i < std::size(LOG_P); ++i)
+			y = y * t + LOG_P[i];
+		y = y * t;
+		y = y * t2;
+
+		const auto fe = static_cast<float>(e);
+		y = y + fe * LOG_Q1;
+		y = y - t2 * 0.5f;
+		t = t + y;
+		return t + fe * LOG_Q2;
+	}
+
+	// sqrt(-2 log(u)) for u in (0, 1] from a word
+	float radiusScalar(const uint32_t word)
+	{
+		const auto u = static_cast<float>(static_cast<int32_t>((word >> UNIFORM_SHIFT) + 1)) * UNIFORM_SCALE;
+		return std::sqrt(logScalar(u) * -2.f);
+	}
+
+	// cos and sin of an angle in [0, 2 pi) from a word
+	void cosSinScalar(const uint32_t word, float &cosOut, float &sinOut)
+	{
+		const auto steps = static_cast<int32_t>(word >> UNIFORM_SHIFT);
+		const auto quarterTurns = (steps + HALF_QUARTER_TURN) >> QUARTER_TURN_SHIFT;
+		const auto theta = static_cast<float>(steps - (quarterTurns << QUARTER_TURN_SHIFT)) * RADIANS_PER_STEP;
+		const auto theta2 = theta * theta;
+
+		auto s = SIN_P[0];
+		s = s * theta2 + SIN_P[1];
+		s = s * theta2 + SIN_P[2];
+		s = s * theta2;
+		s = s * theta;
+		s = s + theta;
+
+		auto c = COS_P[0];
+		c = c * theta2 + COS_P[1];
+		c = c * theta2 + COS_P[2];
+		c = c * theta2;
+		c = c * theta2;
+		c = c - theta2 * 0.5f;
+		c = c + 1.f;
+
+		// Rotate by the quarter turns
+		const bool swap = (quarterTurns & 1) != 0;
+		cosOut = swap ? s : c;
+		sinOut = swap ? c : s;
+		if (quarterTurns & 2)
+			sinOut = -sinOut;
+		if ((quarterTurns + 1) & 2)
+			cosOut = -cosOut;
+	}
+
+	struct GaussianStream
+	{
+		PhiloxKey key;
+		uint64_t stream;
+		float mean;
+		float stdDev;
+	};
+
+	PhiloxCounter blockCounter(const GaussianStream &gs, const uint64_t block)
+	{
+		return { static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32),
+			static_cast<uint32_t>(gs.stream), static_cast<uint32_t>(gs.stream >> 32) };
+	}
+
+	// Two Box-Muller pairs from one Philox block
+	void gaussianBlockScalar(const GaussianStream &gs, const uint64_t block, float *values)
+	{
+		const auto words = philox4x32(blockCounter(gs, block), gs.key);
+
+		float cosA, sinA, cosB, sinB;
+		cosSinScalar(words[1], cosA, sinA);
+		cosSinScalar(words[3], cosB, sinB);
+		const auto radiusA = radiusScalar(words[0]);
+		const auto radiusB = radiusScalar(words[2]);
+
+		values[0] = gs.mean + gs.stdDev * (radiusA * cosA);
+		values[1] = gs.mean + gs.stdDev * (radiusA * sinA);
+		values[2] = gs.mean + gs.stdDev * (radiusB * cosB);
+		values[3] = gs.mean + gs.stdDev * (radiusB * sinB);
+	}
+
+	void gaussianBlocksScalar(const GaussianStream &gs, const uint64_t firstBlock, const size_t begin, const size_t end, float *values)
+	{
+		for (auto b = begin; b < end; ++b)
+			gaussianBlockScalar(gs, firstBlock + b, values + 4 * b);
+	}
+
+	// SIMD kernels hold one word of a block's counter for several blocks in each register
+	// The low word of the block number goes up by one per lane, so a register can't span it wrapping
+
+	// 32 x 32 bit products of every lane with m (the same in every lane)
+	void mulHiLoSse2(const __m128i a, const __m128i m, __m128i &hi, __m128i &lo)
+	{
+		const auto lowMask = _mm_set_epi32(0, -1, 0, -1);
+		const auto evenProducts = _mm_mul_epu32(a, m);
+		const auto oddProducts = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+		lo = _mm_or_si128(_mm_and_si128(evenProducts, lowMask), _mm_slli_epi64(oddProducts, 32));
+		hi = _mm_or_si128(_mm_srli_epi64(evenProducts, 32), _mm_andnot_si128(lowMask, oddProducts));
+	}
+
+	void philoxSse2(__m128i c[4], PhiloxKey key)
+	{
+		const auto m0 = _mm_set1_epi32(static_cast<int>(PHILOX_M0));
+		const auto m1 = _mm_set1_epi32(static_cast<int>(PHILOX_M1));
+		for (int round = 0; round < PHILOX_ROUNDS; ++round)
+		{
+			if (round > 0)
+			{
+				key[0] += PHILOX_W0;
+				key[1] += PHILOX_W1;
+			}
+
+			__m128i hi0, lo0, hi1, lo1;
+			mulHiLoSse2(c[0], m0, hi0, lo0);
+			mulHiLoSse2(c[2], m1, hi1, lo1);
+			c[0] = _mm_xor_si128(_mm_xor_si128(hi1, c[1]), _mm_set1_epi32(static_cast<int>(key[0])));
+			c[1] = lo1;
+			c[2] = _mm_xor_si128(_mm_xor_si128(hi0, c[3]), _mm_set1_epi32(static_cast<int>(key[1])));
+			c[3] = lo0;
+		}
+	}
+
+	__m128 logSse2(const __m128 x)
+	{
+		const auto bits = _mm_castps_si128(x);
+		auto e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126));
+		const auto m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F000000)));
+
+		// Adding the all ones mask subtracts one
+		const auto small = _mm_cmplt_ps(m, _mm_set1_ps(SQRT_HALF));
+		e = _mm_add_epi32(e, _mm_castps_si128(small));
+		auto t = _mm_sub_ps(m, _mm_set1_ps(1.f));
+		t = _mm_add_ps(t, _mm_and_ps(m, small));
+
+		const auto t2 = _mm_mul_ps(t, t);
+		auto y = _mm_set1_ps(LOG_P[0]);
+		for (size_t i = 1; i < std::size(LOG_P); ++i)
+			y = _mm_add_ps(_mm_mul_ps(y, t), _mm_set1_ps(LOG_P[i]));
+		y = _mm_mul_ps(y, t);
+		y = _mm_mul_ps(y, t2);
+
+		const auto fe = _mm_cvtepi32_ps(e);
+		y = _mm_add_ps(y, _mm_mul_ps(fe, _mm_set1_ps(LOG_Q1)));
+		y = _mm_sub_ps(y, _mm_mul_ps(t2, _mm_set1_ps(0.5f)));
+		t = _mm_add_ps(t, y);
+		return _mm_add_ps(t, _mm_mul_ps(fe, _mm_set1_ps(LOG_Q2)));
+	}
+
+	__m128 radiusSse2(const __m128i words)
+	{
+		const auto n = _mm_add_epi32(_mm_srli_epi32(words, UNIFORM_SHIFT), _mm_set1_epi32(1));
+		const auto u = _mm_mul_ps(_mm_cvtepi32_ps(n), _mm_set1_ps(UNIFORM_SCALE));
+		return _mm_sqrt_ps(_mm_mul_ps(logSse2(u), _mm_set1_ps(-2.f)));
+	}
+
+	void cosSinSse2(const __m128i words, __m128 &cosOut, __m128 &sinOut)
+	{
+		const auto steps = _mm_srli_epi32(words, UNIFORM_SHIFT);
+		const auto quarterTurns = _mm_srai_epi32(_mm_add_epi32(steps, _mm_set1_epi32(HALF_QUARTER_TURN)), QUARTER_TURN_SHIFT);
+		const auto theta = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(steps, _mm_slli_epi32(quarterTurns, QUARTER_TURN_SHIFT))), _mm_set1_ps(RADIANS_PER_STEP));
+		const auto theta2 = _mm_mul_ps(theta, theta);
+
+		auto s = _mm_set1_ps(SIN_P[0]);
+		s = _mm_add_ps(_mm_mul_ps(s, theta2), _mm_set1_ps(SIN_P[1]));
+		s = _mm_add_ps(_mm_mul_ps(s, theta2), _mm_set1_ps(SIN_P[2]));
+		s = _mm_mul_ps(s, theta2);
+		s = _mm_mul_ps(s, theta);
+		s = _mm_add_ps(s, theta);
+
+		auto c = _mm_set1_ps(COS_P[0]);
+		c = _mm_add_ps(_mm_mul_ps(c, theta2), _mm_set1_ps(COS_P[1]));
+		c = _mm_add_ps(_mm_mul_ps(c, theta2), _mm_set1_ps(COS_P[2]));
+		c = _mm_mul_ps(c, theta2);
+		c = _mm_mul_ps(c, theta2);
+		c = _mm_sub_ps(c, _mm_mul_ps(theta2, _mm_set1_ps(0.5f)));
+		c = _mm_add_ps(c, _mm_set1_ps(1.f));
+
+		// Rotate by the quarter turns, flipping signs by their sign bits
+		const auto one = _mm_set1_epi32(1);
+		const auto two = _mm_set1_epi32(2);
+		const auto swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quarterTurns, one), one));
+		const auto sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quarterTurns, two), 30));
+		const auto cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quarterTurns, one), two), 30));
+		cosOut = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosSign);
+		sinOut = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sinSign);
+	}
+
+	size_t gaussianBlocksSse2(const GaussianStream &gs, const uint64_t firstBlock, const size_t begin, const size_t end, float *values)
+	{
+		const auto mean = _mm_set1_ps(gs.mean);
+		const auto stdDev = _mm_set1_ps(gs.stdDev);
+		const auto laneOffsets = _mm_set_epi32(3, 2, 1, 0);
+
+		auto b = begin;
+		for (; b + 4 <= end; b += 4)
+		{
+			const auto counter = blockCounter(gs, firstBlock + b);
+			if (counter[0] > UINT32_MAX - 3)
+			{
+				gaussianBlocksScalar(gs, firstBlock, b, b + 4, values);
+				continue;
+			}
+
+			__m128i c[4] = {
+				_mm_add_epi32(_mm_set1_epi32(static_cast<int>(counter[0])), laneOffsets),
+				_mm_set1_epi32(static_cast<int>(counter[1])),
+				_mm_set1_epi32(static_cast<int>(counter[2])),
+				_mm_set1_epi32(static_cast<int>(counter[3])) };
+			philoxSse2(c, gs.key);
+
+			__m128 cosA, sinA, cosB, sinB;
+			cosSinSse2(c[1], cosA, sinA);
+			cosSinSse2(c[3], cosB, sinB);
+			const auto radiusA = radiusSse2(c[0]);
+			const auto radiusB = radiusSse2(c[2]);
+
+			// Each register has one value of 4 blocks, so transpose them into block order
+			auto v0 = _mm_add_ps(mean, _mm_mul_ps(stdDev, _mm_mul_ps(radiusA, cosA)));
+			auto v1 = _mm_add_ps(mean, _mm_mul_ps(stdDev, _mm_mul_ps(radiusA, sinA)));
+			auto v2 = _mm_add_ps(mean, _mm_mul_ps(stdDev, _mm_mul_ps(radiusB, cosB)));
+			auto v3 = _mm_add_ps(mean, _mm_mul_ps(stdDev, _mm_mul_ps(radiusB, sinB)));
+			_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+
+			_mm_storeu_ps(values + 4 * b, v0);
+			_mm_storeu_ps(values + 4 * b + 4, v1);
+			_mm_storeu_ps(values + 4 * b + 8, v2);
+			_mm_storeu_ps(values + 4 * b + 12, v3);
+		}
+
+		return b;
+	}
+
+	void mulHiLoAvx2(const __m256i a, const __m256i m, __m256i &hi, __m256i &lo)
+	{
+		const auto lowMask = _mm256_set1_epi64x(0xFFFFFFFF);
+		const auto evenProducts = _mm256_mul_epu32(a, m);
+		const auto oddProducts = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+		lo = _mm256_or_si256(_mm256_and_si256(evenProducts, lowMask), _mm256_slli_epi64(oddProducts, 32));
+		hi = _mm256_or_si256(_mm256_srli_epi64(evenProducts, 32), _mm256_andnot_si256(lowMask, oddProducts));
+	}
+
+	void philoxAvx2(__m256i c[4], PhiloxKey key)
+	{
+		const auto m0 = _mm256_set1_epi32(static_cast<int>(PHILOX_M0));
+		const auto m1 = _mm256_set1_epi32(static_cast<int>(PHILOX_M1));
+		for (int round = 0; round < PHILOX_ROUNDS; ++round)
+		{
+			if (round > 0)
+			{
+				key[0] += PHILOX_W0;
+				key[1] += PHILOX_W1;
+			}
+
+			__m256i hi0, lo0, hi1, lo1;
+			mulHiLoAvx2(c[0], m0, hi0, lo0);
+			mulHiLoAvx2(c[2], m1, hi1, lo1);
+			c[0] = _mm256_xor_si256(_mm256_xor_si256(hi1, c[1]), _mm256_set1_epi32(static_cast<int>(key[0])));
+			c[1] = lo1;
+			c[2] = _mm256_xor_si256(_mm256_xor_si256(hi0, c[3]), _mm256_set1_epi32(static_cast<int>(key[1])));
+			c[3] = lo0;
+		}
+	}
+
+	__m256 logAvx2(const __m256 x)
+	{
+		const auto bits = _mm256_castps_si256(x);
+		auto e = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126));
+		const auto m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F000000)));
+
+		// Adding the all ones mask subtracts one
+		const auto small = _mm256_cmp_ps(m, _mm256_set1_ps(SQRT_HALF), _CMP_LT_OQ);
+		e = _mm256_add_epi32(e, _mm256_castps_si256(small));
+		auto t = _mm256_sub_ps(m, _mm256_set1_ps(1.f));
+		t = _mm256_add_ps(t, _mm256_and_ps(m, small));
+
+		const auto t2 = _mm256_mul_ps(t, t);
+		auto y = _mm256_set1_ps(LOG_P[0]);
+		for (size_t i = 1; i < std::size(LOG_P); ++i)
+			y = _mm256_add_ps(_mm256_mul_ps(y, t), _mm256_set1_ps(LOG_P[i]));
+		y = _mm256_mul_ps(y, t);
+		y = _mm256_mul_ps(y, t2);
+
+		const auto fe = _mm256_cvtepi32_ps(e);
+		y = _mm256_add_ps(y, _mm256_mul_ps(fe, _mm256_set1_ps(LOG_Q1)));
+		y = _mm256_sub_ps(y, _mm256_mul_ps(t2, _mm256_set1_ps(0.5f)));
+		t = _mm256_add_ps(t, y);
+		return _mm256_add_ps(t, _mm256_mul_ps(fe, _mm256_set1_ps(LOG_Q2)));
+	}
+
+	__m256 radiusAvx2(const __m256i words)
+	{
+		const auto n = _mm256_add_epi32(_mm256_srli_epi32(words, UNIFORM_SHIFT), _mm256_set1_epi32(1));
+		const auto u = _mm256_mul_ps(_mm256_cvtepi32_ps(n), _mm256_set1_ps(UNIFORM_SCALE));
+		return _mm256_sqrt_ps(_mm256_mul_ps(logAvx2(u), _mm256_set1_ps(-2.f)));
+	}
+
+	void cosSinAvx2(const __m256i words, __m256 &cosOut, __m256 &sinOut)
+	{
+		const auto steps = _mm256_srli_epi32(words, UNIFORM_SHIFT);
+		const auto quarterTurns = _mm256_srai_epi32(_mm256_add_epi32(steps, _mm256_set1_epi32(HALF_QUARTER_TURN)), QUARTER_TURN_SHIFT);
+		const auto theta = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(steps, _mm256_slli_epi32(quarterTurns, QUARTER_TURN_SHIFT))), _mm256_set1_ps(RADIANS_PER_STEP));
+		const auto theta2 = _mm256_mul_ps(theta, theta);
+
+		auto s = _mm256_set1_ps(SIN_P[0]);
+		s = _mm256_add_ps(_mm256_mul_ps(s, theta2), _mm256_set1_ps(SIN_P[1]));
+		s = _mm256_add_ps(_mm256_mul_ps(s, theta2), _mm256_set1_ps(SIN_P[2]));
+		s = _mm256_mul_ps(s, theta2);
+		s = _mm256_mul_ps(s, theta);
+		s = _mm256_add_ps(s, theta);
+
+		auto c = _mm256_set1_ps(COS_P[0]);
+		c = _mm256_add_ps(_mm256_mul_ps(c, theta2), _mm256_set1_ps(COS_P[1]));
+		c = _mm256_add_ps(_mm256_mul_ps(c, theta2), _mm256_set1_ps(COS_P[2]));
+		c = _mm256_mul_ps(c, theta2);
+		c = _mm256_mul_ps(c, theta2);
+		c = _mm256_sub_ps(c, _mm256_mul_ps(theta2, _mm256_set1_ps(0.5f)));
+		c = _mm256_add_ps(c, _mm256_set1_ps(1.f));
+
+		// Rotate by the quarter turns, flipping signs by their sign bits
+		const auto one = _mm256_set1_epi32(1);
+		const auto two = _mm256_set1_epi32(2);
+		const auto swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quarterTurns, one), one));
+		const auto sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quarterTurns, two), 30));
+		const auto cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quarterTurns, one), two), 30));
+		cosOut = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosSign);
+		sinOut = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sinSign);
+	}
+
+	size_t gaussianBlocksAvx2(const GaussianStream &gs, const uint64_t firstBlock, const size_t begin, const size_t end, float *values)
+	{
+		const auto mean = _mm256_set1_ps(gs.mean);
+		const auto stdDev = _mm256_set1_ps(gs.stdDev);
+		const auto laneOffsets = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+		auto b = begin;
+		for (; b + 8 <= end; b += 8)
+		{
+			const auto counter = blockCounter(gs, firstBlock + b);
+			if (counter[0] > UINT32_MAX - 7)
+			{
+				gaussianBlocksScalar(gs, firstBlock, b, b + 8, values);
+				continue;
+			}
+
+			__m256i c[4] = {
+				_mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(counter[0])), laneOffsets),
+				_mm256_set1_epi32(static_cast<int>(counter[1])),
+				_mm256_set1_epi32(static_cast<int>(counter[2])),
+				_mm256_set1_epi32(static_cast<int>(counter[3])) };
+			philoxAvx2(c, gs.key);
+
+			__m256 cosA, sinA, cosB, sinB;
+			cosSinAvx2(c[1], cosA, sinA);
+			cosSinAvx2(c[3], cosB, sinB);
+			const auto radiusA = radiusAvx2(c[0]);
+			const auto radiusB = radiusAvx2(c[2]);
+
+			const auto v0 = _mm256_add_ps(mean, _mm256_mul_ps(stdDev, _mm256_mul_ps(radiusA, cosA)));
+			const auto v1 = _mm256_add_ps(mean, _mm256_mul_ps(stdDev, _mm256_mul_ps(radiusA, sinA)));
+			const auto v2 = _mm256_add_ps(mean, _mm256_mul_ps(stdDev, _mm256_mul_ps(radiusB, cosB)));
+			const auto v3 = _mm256_add_ps(mean, _mm256_mul_ps(stdDev, _mm256_mul_ps(radiusB, sinB)));
+
+			// Transpose within each 128 bit half (blocks 0-3 and 4-7), then gather the halves into block order
+			const auto t0 = _mm256_unpacklo_ps(v0, v1);
+			const auto t1 = _mm256_unpackhi_ps(v0, v1);
+			const auto t2 = _mm256_unpacklo_ps(v2, v3);
+			const auto t3 = _mm256_unpackhi_ps(v2, v3);
+			const auto r0 = _mm256_shuffle_ps(t0, t2, 0x44);
+			const auto r1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+			const auto r2 = _mm256_shuffle_ps(t1, t3, 0x44);
+			const auto r3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+
+			_mm256_storeu_ps(values + 4 * b, _mm256_permute2f128_ps(r0, r1, 0x20));
+			_mm256_storeu_ps(values + 4 * b + 8, _mm256_permute2f128_ps(r2, r3, 0x20));
+			_mm256_storeu_ps(values + 4 * b + 16, _mm256_permute2f128_ps(r0, r1, 0x31));
+			_mm256_storeu_ps(values + 4 * b + 24, _mm256_permute2f128_ps(r2, r3, 0x31));
+		}
+
+		return b;
+	}
+
+	void gaussianBlocks(const GaussianStream &gs, const uint64_t firstBlock, const size_t nBlocks, float *values, const SimdLevel simdLevel)
+	{
+		runSimdKernels(simdLevel, 0, nBlocks,
+			[&](size_t begin, size_t end) { return gaussianBlocksAvx2(gs, firstBlock, begin, end, values); },
+			[&](size_t begin, size_t end) { return gaussianBlocksSse2(gs, firstBlock, begin, end, values); },
+			[&](size_t begin, size_t end) { gaussianBlocksScalar(gs, firstBlock, begin, end, values); });
+	}
+}
+
+PhiloxCounter reindeer::philox4x32(PhiloxCounter counter, PhiloxKey key)
+{
+	for (int round = 0; round < PHILOX_ROUNDS; ++round)
+	{
+		if (round > 0)
+		{
+			key[0] += PHILOX_W0;
+			key[1] += PHILOX_W1;
+		}
+
+		const auto product0 = static_cast<uint64_t>(PHILOX_M0) * counter[0];
+		const auto product1 = static_cast<uint64_t>(PHILOX_M1) * counter[2];
+		counter = {
+			static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+			static_cast<uint32_t>(product1),
+			static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+			static_cast<uint32_t>(product0) };
+	}
+
+	return counter;
+}
+
+void reindeer::fillGaussian(float *values, size_t n, float mean, float stdDev, PhiloxKey key, uint64_t stream, uint64_t firstIndex)
+{
+	static const auto simdLevel = detectSimdLevel();
+	fillGaussian(values, n, mean, stdDev, key, stream, firstIndex, simdLevel);
+}
+
+void reindeer::fillGaussian(float *values, size_t n, float mean, float stdDev, PhiloxKey key, uint64_t stream, uint64_t firstIndex, SimdLevel simdLevel)
+{
+	const GaussianStream gs = { key, stream, mean, stdDev };
+
+	// Whole blocks are written in place, a partial block at either end is made aside and copied
+	auto block = firstIndex / 4;
+	const auto offset = static_cast<size_t>(firstIndex % 4);
+	if (offset != 0 && n > 0)
+	{
+		float blockValues[4];
+		gaussianBlockScalar(gs, block, blockValues);
+		const auto nCopied = std::min(n, 4 - offset);
+		std::copy_n(blockValues + offset, nCopied, values);
+		values += nCopied;
+		n -= nCopied;
+		++block;
+	}
+
+	const auto nWholeBlocks = n / 4;
+	gaussianBlocks(gs, block, nWholeBlocks, values, simdLevel);
+
+	const auto nLeft = n % 4;
+	if (nLeft != 0)
+	{
+		float blockValues[4];
+		gaussianBlockScalar(gs, block + nWholeBlocks, blockValues);
+		std::copy_n(blockValues, nLeft, values + 4 * nWholeBlocks);
+	}
+}
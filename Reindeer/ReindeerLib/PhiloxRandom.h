@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "SimdDispatch.h"
+
+namespace reindeer
+{
+	using PhiloxCounter = std::array<uint32_t, 4>;
+	using PhiloxKey = std::array<uint32_t, 2>;
+
+	// The Philox4x32-10 counter based generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+	// Returns 4 random words for a counter and key, with no state, so any part of a stream can be made independently
+	PhiloxCounter philox4x32(PhiloxCounter counter, PhiloxKey key);
+
+	// Fills values[0, n) with normally distributed values from the stream picked by key and stream
+	// values[i] is element firstIndex + i of the stream, and only depends on (key, stream, firstIndex + i),
+	// so a stream can be filled in pieces, in any order or on several threads
+	// Each Philox block gives 4 values through Box-Muller, with its log, sin and cos done by polynomials in SIMD lanes
+	void fillGaussian(float *values, size_t n, float mean, float stdDev, PhiloxKey key, uint64_t stream, uint64_t firstIndex = 0);
+
+	// Uses a particular SIMD level, which must be supported
+	// Gives identical values at every SIMD level
+	void fillGaussian(float *values, size_t n, float mean, float stdDev, PhiloxKey key, uint64_t stream, uint64_t firstIndex, SimdLevel simdLevel);
+}
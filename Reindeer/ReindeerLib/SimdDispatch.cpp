@@ -0,0 +1,33 @@
+#include "SimdDispatch.h"
+
+using namespace reindeer;
+
+SimdLevel reindeer::detectSimdLevel()
+{
+	int info[4];
+	__cpuid(info, 0);
+	const auto maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	const bool hasSse2 = (info[3] & (1 << 26)) != 0;
+	const bool hasOsXsave = (info[2] & (1 << 27)) != 0;
+	const bool hasAvx = (info[2] & (1 << 28)) != 0;
+
+	bool hasAvx2 = false;
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		hasAvx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	// The OS must also save the upper halves of the AVX registers
+	const bool osSavesAvx = hasOsXsave && (_xgetbv(0) & 0x6) == 0x6;
+
+	if (hasAvx && hasAvx2 && osSavesAvx)
+		return SimdLevel::AVX2;
+
+	if (hasSse2)
+		return SimdLevel::SSE2;
+
+	return SimdLevel::SCALAR;
+}
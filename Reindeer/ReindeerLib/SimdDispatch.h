@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <intrin.h>
+
+namespace reindeer
+{
+	enum class SimdLevel
+	{
+		SCALAR,
+		SSE2,
+		AVX2
+	};
+
+	// The best level the CPU (and OS) supports
+	SimdLevel detectSimdLevel();
+
+	// Runs a function's kernels over [begin, end), the widest the level allows first, with narrower ones taking the remainder
+	// The SIMD kernels take (begin, end) and return how far their whole vectors got, the scalar kernel finishes the rest
+	// Kernels for a function use the same operations in the same order, so every level gives identical results
+	// AVX intrinsics are allowed without /arch:AVX2, as the AVX2 kernel is only called once the CPU is known to support it
+	template <typename Avx2Kernel, typename Sse2Kernel, typename ScalarKernel>
+	void runSimdKernels(const SimdLevel simdLevel, const size_t begin, const size_t end,
+		const Avx2Kernel &avx2, const Sse2Kernel &sse2, const ScalarKernel &scalar)
+	{
+		auto i = begin;
+		if (simdLevel == SimdLevel::AVX2)
+		{
+			i = avx2(i, end);
+
+			// Avoid the penalty for switching back to SSE code
+			_mm256_zeroupper();
+		}
+
+		if (simdLevel != SimdLevel::SCALAR)
+			i = sse2(i, end);
+
+		scalar(i, end);
+	}
+}
@@ -0,0 +1,86 @@
+#include "SplitAggregator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace reindeer;
+
+SplitAggregator::SplitAggregator(SplitAxis axis, double interval, double minMovingPace) :
+	axis(axis),
+	interval(interval),
+	minMovingPace(minMovingPace)
+{
+	if (!(interval > 0.0))
+		throw std::invalid_argument("Split interval must be positive");
+}
+
+void SplitAggregator::addStepFraction(const DistTimeElev &step, bool moving, double fraction)
+{
+	const auto part = DistTimeElev(
+		DistanceTime(fraction * step.distanceTime.distance_m, fraction * step.distanceTime.time_s),
+		ElevationInfo(fraction * step.elevation.elevationDiff_m, fraction * step.elevation.cumulativeElevation_m));
+
+	split.distTimeElev = DistTimeElev::sum(split.distTimeElev, part);
+	if (moving)
+		split.movingTime_s += part.distanceTime.time_s;
+}
+
+void SplitAggregator::append(const GpxPoint &point, std::vector<Split> &completedSplits)
+{
+	if (nAppended++ == 0)
+	{
+		previous = point;
+		return;
+	}
+
+	// A point earlier than the one before it is a step taking no time, rather than wrapping the unsigned time difference
+	auto stepEnd = point;
+	stepEnd.dateTime_ms = std::max(point.dateTime_ms, previous.dateTime_ms);
+	const auto step = DistTimeElev::fromGpx(previous, stepEnd);
+	previous = point;
+
+	const auto moving = step.distanceTime.pace_ms() > minMovingPace;
+	const auto length = axis == SplitAxis::DISTANCE ? step.distanceTime.distance_m : step.distanceTime.time_s;
+
+	// Fraction of the step already added, as it may cross several boundaries
+	double added = 0.0;
+	if (length > 0.0)
+	{
+		for (auto boundary = static_cast<double>(nCompleted + 1) * interval;
+			boundary <= position + length;
+			boundary = static_cast<double>(nCompleted + 1) * interval)
+		{
+			const auto toBoundary = (boundary - position) / length;
+			addStepFraction(step, moving, toBoundary - added);
+			added = toBoundary;
+
+			completedSplits.push_back(split);
+			split = Split(DistTimeElev::zero(), 0.0);
+			++nCompleted;
+		}
+	}
+
+	addStepFraction(step, moving, 1.0 - added);
+	position += length;
+}
+
+void SplitAggregator::append(const GpxPoint *points, size_t nPoints, std::vector<Split> &completedSplits)
+{
+	for (size_t i = 0; i < nPoints; ++i)
+		append(points[i], completedSplits);
+}
+
+const Split &SplitAggregator::current() const
+{
+	return split;
+}
+
+size_t SplitAggregator::completedCount() const
+{
+	return nCompleted;
+}
+
+size_t SplitAggregator::pointCount() const
+{
+	return nAppended;
+}
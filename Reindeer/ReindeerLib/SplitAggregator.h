@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+
+#include "ActivityStructures.h"
+
+namespace reindeer
+{
+	struct Split
+	{
+		DistTimeElev distTimeElev;
+
+		// Time in steps faster than the aggregator's minMovingPace
+		double movingTime_s;
+
+		Split(DistTimeElev distTimeElev, double movingTime_s) :
+			distTimeElev(distTimeElev), movingTime_s(movingTime_s)
+		{
+
+		}
+
+		Split() = delete;
+	};
+
+	enum class SplitAxis
+	{
+		DISTANCE,
+		TIME
+	};
+
+	// Splits an activity every interval along an axis (e.g. per km, or per 5 minutes) as its gpx points arrive
+	// Keeps only the previous point and the split in progress, so any length of activity takes O(1) state
+	// A step crossing a boundary is divided between the splits in proportion to how far along it the boundary is
+	// Steps are as DistTimeElev::fromGpx, so the splits add up to the activity's total
+	// A point timed before the one before it makes a step taking no time, and the following step is timed from it
+	class SplitAggregator
+	{
+	public:
+		// interval is in distance_m or time_s (as DistTimeElev), depending on the axis
+		// minMovingPace is in m/s (as DistanceTime::pace_ms)
+		// Throws std::invalid_argument if interval isn't positive
+		SplitAggregator(SplitAxis axis, double interval, double minMovingPace = 0.0);
+
+		// Adds the points, appending any splits they complete to completedSplits
+		void append(const GpxPoint &point, std::vector<Split> &completedSplits);
+		void append(const GpxPoint *points, size_t nPoints, std::vector<Split> &completedSplits);
+
+		// The split in progress (e.g. the last, partial, split once the activity has ended)
+		const Split &current() const;
+
+		size_t completedCount() const;
+		size_t pointCount() const;
+
+	private:
+		const SplitAxis axis;
+		const double interval;
+		const double minMovingPace;
+
+		GpxPoint previous = GpxPoint(0.0, 0.0, 0.0, 0);
+		size_t nAppended = 0;
+
+		// Position along the axis of the previous point, and of the end of the split in progress
+		double position = 0.0;
+		size_t nCompleted = 0;
+		Split split = Split(DistTimeElev::zero(), 0.0);
+
+		void addStepFraction(const DistTimeElev &step, bool moving, double fraction);
+	};
+}
@@ -0,0 +1,194 @@
+#include "Timestamp.h"
+
+#include <stdexcept>
+
+using namespace reindeer;
+
+namespace
+{
+	// Days since 1970-01-01 in the proleptic Gregorian calendar
+	int64_t daysFromCivil(int year, const int month, const int day)
+	{
+		year -= month <= 2 ? 1 : 0;
+		const int64_t era = (year >= 0 ? year : year - 399) / 400;
+		const auto yearOfEra = static_cast<int64_t>(year) - era * 400;
+		const auto dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+		const auto dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+		return era * 146097 + dayOfEra - 719468;
+	}
+
+	int daysInMonth(const int year, const int month)
+	{
+		constexpr int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+		const auto isLeapYear = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+		return month == 2 && isLeapYear ? 29 : days[month - 1];
+	}
+
+	bool isValidDateTime(const int year, const int month, const int day, const int hour, const int minute, const int second)
+	{
+		// Allow for a leap second
+		return month >= 1 && month <= 12 && day >= 1 && day <= daysInMonth(year, month) &&
+			hour <= 23 && minute <= 59 && second <= 60;
+	}
+
+	// Negative before the epoch
+	int64_t toEpoch_ms(const int year, const int month, const int day,
+		const int hour, const int minute, const int second, const int64_t millisecond)
+	{
+		const auto seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+		return seconds * 1000 + millisecond;
+	}
+
+	// YYYY-MM-DDThh:mm:ssZ or YYYY-MM-DDThh:mm:ss.sssZ
+	// Every character is checked and converted without branching on it, and the checks are combined at the end
+	bool tryParseCanonical_ms(const char *p, const size_t length, uint64_t &dateTime_ms)
+	{
+		const auto hasFraction = length == 24;
+		if (length != 20 && !hasFraction)
+			return false;
+
+		const auto digit = [p](size_t i)
+		{
+			return static_cast<unsigned>(static_cast<unsigned char>(p[i]) - static_cast<unsigned char>('0'));
+		};
+
+		constexpr size_t digitPositions[] = { 0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18 };
+		unsigned d[14];
+		unsigned invalid = 0;
+		for (size_t i = 0; i < 14; ++i)
+		{
+			d[i] = digit(digitPositions[i]);
+			invalid |= d[i] > 9 ? 1u : 0u;
+		}
+
+		invalid |= static_cast<unsigned>(p[4] ^ '-') | static_cast<unsigned>(p[7] ^ '-') | static_cast<unsigned>(p[10] ^ 'T') |
+			static_cast<unsigned>(p[13] ^ ':') | static_cast<unsigned>(p[16] ^ ':') | static_cast<unsigned>(p[length - 1] ^ 'Z');
+
+		unsigned millisecond = 0;
+		if (hasFraction)
+		{
+			const auto m0 = digit(20), m1 = digit(21), m2 = digit(22);
+			invalid |= static_cast<unsigned>(p[19] ^ '.') | (m0 > 9 ? 1u : 0u) | (m1 > 9 ? 1u : 0u) | (m2 > 9 ? 1u : 0u);
+			millisecond = m0 * 100 + m1 * 10 + m2;
+		}
+
+		const auto year = static_cast<int>(d[0] * 1000 + d[1] * 100 + d[2] * 10 + d[3]);
+		const auto month = static_cast<int>(d[4] * 10 + d[5]);
+		const auto day = static_cast<int>(d[6] * 10 + d[7]);
+		const auto hour = static_cast<int>(d[8] * 10 + d[9]);
+		const auto minute = static_cast<int>(d[10] * 10 + d[11]);
+		const auto second = static_cast<int>(d[12] * 10 + d[13]);
+		if (invalid != 0 || !isValidDateTime(year, month, day, hour, minute, second))
+			return false;
+
+		// Leaves times before the epoch to the general parser to reject
+		const auto epoch_ms = toEpoch_ms(year, month, day, hour, minute, second, millisecond);
+		if (epoch_ms < 0)
+			return false;
+
+		dateTime_ms = static_cast<uint64_t>(epoch_ms);
+		return true;
+	}
+
+	// Parses the digits in [p, p + n)
+	bool parseDigits(const char *p, const int n, int &value)
+	{
+		value = 0;
+		for (int i = 0; i < n; ++i)
+		{
+			if (p[i] < '0' || p[i] > '9')
+				return false;
+
+			value = value * 10 + (p[i] - '0');
+		}
+
+		return true;
+	}
+
+	// Any fraction length, 'Z' or an offset (+hh:mm, +hhmm or +hh), and a lower case 't' or a space as the separator
+	uint64_t parseGeneral_ms(const char *begin, const char *end)
+	{
+		const auto invalid = []()
+		{
+			return std::runtime_error("Invalid ISO 8601 date-time");
+		};
+
+		int year, month, day, hour, minute, second;
+		const auto p = begin;
+		if (end - p < 19 ||
+			!parseDigits(p, 4, year) || p[4] != '-' ||
+			!parseDigits(p + 5, 2, month) || p[7] != '-' ||
+			!parseDigits(p + 8, 2, day) || (p[10] != 'T' && p[10] != 't' && p[10] != ' ') ||
+			!parseDigits(p + 11, 2, hour) || p[13] != ':' ||
+			!parseDigits(p + 14, 2, minute) || p[16] != ':' ||
+			!parseDigits(p + 17, 2, second) ||
+			!isValidDateTime(year, month, day, hour, minute, second))
+		{
+			throw invalid();
+		}
+
+		auto q = p + 19;
+
+		// Fraction of a second, truncated to the ms
+		int64_t millisecond = 0;
+		if (q < end && (*q == '.' || *q == ','))
+		{
+			++q;
+			if (q == end || *q < '0' || *q > '9')
+				throw invalid();
+
+			int64_t scale = 100;
+			for (; q < end && *q >= '0' && *q <= '9'; ++q)
+			{
+				millisecond += scale * (*q - '0');
+				scale /= 10;
+			}
+		}
+
+		int offset_minutes = 0;
+		if (q < end && (*q == 'Z' || *q == 'z'))
+		{
+			++q;
+		}
+		else if (q < end && (*q == '+' || *q == '-'))
+		{
+			int offsetHours = 0, offsetMinutes = 0;
+			if (end - q < 3 || !parseDigits(q + 1, 2, offsetHours))
+				throw invalid();
+
+			auto r = q + 3;
+			const auto hasColon = r < end && *r == ':';
+			if (hasColon)
+				++r;
+
+			if (end - r >= 2 && parseDigits(r, 2, offsetMinutes))
+				r += 2;
+			else if (hasColon)
+				throw invalid();
+
+			if (offsetHours > 23 || offsetMinutes > 59)
+				throw invalid();
+
+			offset_minutes = (*q == '-' ? -1 : 1) * (offsetHours * 60 + offsetMinutes);
+			q = r;
+		}
+
+		if (q != end)
+			throw invalid();
+
+		const auto epoch_ms = toEpoch_ms(year, month, day, hour, minute, second, millisecond) - static_cast<int64_t>(offset_minutes) * 60000;
+		if (epoch_ms < 0)
+			throw std::runtime_error("ISO 8601 date-time is before the Unix epoch");
+
+		return static_cast<uint64_t>(epoch_ms);
+	}
+}
+
+uint64_t reindeer::parseIso8601_ms(const char *begin, const char *end)
+{
+	uint64_t dateTime_ms;
+	if (end > begin && tryParseCanonical_ms(begin, static_cast<size_t>(end - begin), dateTime_ms))
+		return dateTime_ms;
+
+	return parseGeneral_ms(begin, end);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace reindeer
+{
+	// Parses an ISO 8601 date-time in [begin, end) to ms since the Unix epoch (e.g. 2018-05-01T10:20:30.123Z)
+	// The UTC forms with no fraction or a 3 digit fraction take a fast path, without branching per character
+	// Other fractions are truncated to the ms, offsets (e.g. +01:00) are converted to UTC, and no offset is taken as UTC
+	// Throws std::runtime_error if it isn't a valid date-time (including the day of the month), or is before the epoch
+	uint64_t parseIso8601_ms(const char *begin, const char *end);
+}
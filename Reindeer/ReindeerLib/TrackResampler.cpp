@@ -0,0 +1,330 @@
+#include "TrackResampler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <intrin.h>
+#include <numeric>
+#include <stdexcept>
+
+#include "GeoDistance.h"
+
+using namespace reindeer;
+
+namespace
+{
+	// Samples are done in blocks small enough to stay in L1 cache
+	constexpr size_t SAMPLES_PER_BLOCK = 256;
+
+	struct alignas(32) SampleBlock
+	{
+		// Each sample is between points index and index + 1, fraction of the way along
+		int32_t index[SAMPLES_PER_BLOCK];
+		double fraction[SAMPLES_PER_BLOCK];
+	};
+
+	// Every (1 << strideShift)th double, so a GpxPoint field can be read in place
+	struct StridedColumn
+	{
+		const double *values;
+		int strideShift;
+	};
+
+	static_assert(sizeof(GpxPoint) == 4 * sizeof(double), "GpxPoint fields are read as a column with a stride of 4 doubles");
+	constexpr int GPX_POINT_STRIDE_SHIFT = 2;
+
+	struct ColumnToResample
+	{
+		StridedColumn from;
+		double *to;
+	};
+
+	double samplePosition(size_t sample, double interval)
+	{
+		return static_cast<double>(sample) * interval;
+	}
+
+	double interpolationFraction(double position, double from, double to)
+	{
+		const auto length = to - from;
+		if (!(length > 0.0))
+			return 0.0;
+
+		return std::min(std::max((position - from) / length, 0.0), 1.0);
+	}
+
+	void fractionsScalar(const double *axis, size_t firstSample, double interval, size_t begin, size_t end, SampleBlock &block)
+	{
+		for (auto k = begin; k < end; ++k)
+		{
+			const auto i = block.index[k];
+			block.fraction[k] = interpolationFraction(samplePosition(firstSample + k, interval), axis[i], axis[i + 1]);
+		}
+	}
+
+	void interpolateScalar(const StridedColumn &column, const SampleBlock &block, size_t begin, size_t end, double *out)
+	{
+		const auto stride = size_t(1) << column.strideShift;
+		for (auto k = begin; k < end; ++k)
+		{
+			const auto *const from = column.values + (static_cast<size_t>(block.index[k]) << column.strideShift);
+			out[k] = from[0] + block.fraction[k] * (from[stride] - from[0]);
+		}
+	}
+
+	size_t fractionsSse2(const double *axis, size_t firstSample, double interval, size_t begin, size_t end, SampleBlock &block)
+	{
+		const auto zero = _mm_setzero_pd();
+		const auto one = _mm_set1_pd(1.0);
+		const auto intervals = _mm_set1_pd(interval);
+
+		auto k = begin;
+		for (; k + 2 <= end; k += 2)
+		{
+			const auto i0 = block.index[k], i1 = block.index[k + 1];
+			const auto from = _mm_set_pd(axis[i1], axis[i0]);
+			const auto to = _mm_set_pd(axis[i1 + 1], axis[i0 + 1]);
+			const auto samples = static_cast<double>(firstSample + k);
+			const auto position = _mm_mul_pd(_mm_set_pd(samples + 1.0, samples), intervals);
+
+			const auto length = _mm_sub_pd(to, from);
+			const auto fraction = _mm_min_pd(_mm_max_pd(_mm_div_pd(_mm_sub_pd(position, from), length), zero), one);
+			_mm_store_pd(block.fraction + k, _mm_and_pd(_mm_cmpgt_pd(length, zero), fraction));
+		}
+
+		return k;
+	}
+
+	size_t interpolateSse2(const StridedColumn &column, const SampleBlock &block, size_t begin, size_t end, double *out)
+	{
+		const auto stride = size_t(1) << column.strideShift;
+
+		auto k = begin;
+		for (; k + 2 <= end; k += 2)
+		{
+			const auto *const from0 = column.values + (static_cast<size_t>(block.index[k]) << column.strideShift);
+			const auto *const from1 = column.values + (static_cast<size_t>(block.index[k + 1]) << column.strideShift);
+			const auto from = _mm_set_pd(from1[0], from0[0]);
+			const auto to = _mm_set_pd(from1[stride], from0[stride]);
+			const auto fraction = _mm_load_pd(block.fraction + k);
+			_mm_storeu_pd(out + k, _mm_add_pd(from, _mm_mul_pd(fraction, _mm_sub_pd(to, from))));
+		}
+
+		return k;
+	}
+
+	size_t fractionsAvx2(const double *axis, size_t firstSample, double interval, size_t begin, size_t end, SampleBlock &block)
+	{
+		const auto zero = _mm256_setzero_pd();
+		const auto one = _mm256_set1_pd(1.0);
+		const auto intervals = _mm256_set1_pd(interval);
+		const auto laneOffsets = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+
+		auto k = begin;
+		for (; k + 4 <= end; k += 4)
+		{
+			const auto index = _mm_load_si128(reinterpret_cast<const __m128i *>(block.index + k));
+			const auto from = _mm256_i32gather_pd(axis, index, 8);
+			const auto to = _mm256_i32gather_pd(axis + 1, index, 8);
+			const auto samples = _mm256_add_pd(_mm256_set1_pd(static_cast<double>(firstSample + k)), laneOffsets);
+			const auto position = _mm256_mul_pd(samples, intervals);
+
+			const auto length = _mm256_sub_pd(to, from);
+			const auto fraction = _mm256_min_pd(_mm256_max_pd(_mm256_div_pd(_mm256_sub_pd(position, from), length), zero), one);
+			_mm256_store_pd(block.fraction + k, _mm256_and_pd(_mm256_cmp_pd(length, zero, _CMP_GT_OQ), fraction));
+		}
+
+		return k;
+	}
+
+	size_t interpolateAvx2(const StridedColumn &column, const SampleBlock &block, size_t begin, size_t end, double *out)
+	{
+		const auto shift = _mm_cvtsi32_si128(column.strideShift);
+		const auto *const next = column.values + (size_t(1) << column.strideShift);
+
+		auto k = begin;
+		for (; k + 4 <= end; k += 4)
+		{
+			const auto index = _mm_sll_epi32(_mm_load_si128(reinterpret_cast<const __m128i *>(block.index + k)), shift);
+			const auto from = _mm256_i32gather_pd(column.values, index, 8);
+			const auto to = _mm256_i32gather_pd(next, index, 8);
+			const auto fraction = _mm256_load_pd(block.fraction + k);
+			_mm256_storeu_pd(out + k, _mm256_add_pd(from, _mm256_mul_pd(fraction, _mm256_sub_pd(to, from))));
+		}
+
+		return k;
+	}
+
+	void fractions(const double *axis, size_t firstSample, double interval, size_t nInBlock, SampleBlock &block, SimdLevel simdLevel)
+	{
+		runSimdKernels(simdLevel, 0, nInBlock,
+			[&](size_t begin, size_t end) { return fractionsAvx2(axis, firstSample, interval, begin, end, block); },
+			[&](size_t begin, size_t end) { return fractionsSse2(axis, firstSample, interval, begin, end, block); },
+			[&](size_t begin, size_t end) { fractionsScalar(axis, firstSample, interval, begin, end, block); });
+	}
+
+	void interpolate(const StridedColumn &column, const SampleBlock &block, size_t nInBlock, double *out, SimdLevel simdLevel)
+	{
+		runSimdKernels(simdLevel, 0, nInBlock,
+			[&](size_t begin, size_t end) { return interpolateAvx2(column, block, begin, end, out); },
+			[&](size_t begin, size_t end) { return interpolateSse2(column, block, begin, end, out); },
+			[&](size_t begin, size_t end) { interpolateScalar(column, block, begin, end, out); });
+	}
+
+	void checkInterval(double interval)
+	{
+		if (!(interval > 0.0))
+			throw std::invalid_argument("Resampling interval must be positive");
+	}
+
+	size_t sampleCount(const AlignedVector<double> &axis, double interval)
+	{
+		if (axis.empty())
+			return 0;
+
+		const auto nIntervals = std::floor(axis.back() / interval);
+		if (nIntervals > 1e12)
+			throw std::invalid_argument("Resampling interval is too small for the track");
+
+		return static_cast<size_t>(std::max(nIntervals, 0.0)) + 1;
+	}
+
+	// Writes the samples at multiples of interval along axis for each column
+	template <size_t N>
+	void resampleColumns(const AlignedVector<double> &axis, double interval, size_t nSamples,
+		const std::array<ColumnToResample, N> &columns, size_t nColumns, SimdLevel simdLevel)
+	{
+		const auto nPoints = axis.size();
+		if (nPoints == 1)
+		{
+			for (size_t c = 0; c < nColumns; ++c)
+				columns[c].to[0] = columns[c].from.values[0];
+			return;
+		}
+
+		SampleBlock block;
+		size_t i = 0;
+		for (size_t first = 0; first < nSamples; first += SAMPLES_PER_BLOCK)
+		{
+			const auto nInBlock = std::min(SAMPLES_PER_BLOCK, nSamples - first);
+
+			// Walk the points, so each sample is between the last point at or before it and the next
+			for (size_t k = 0; k < nInBlock; ++k)
+			{
+				const auto position = samplePosition(first + k, interval);
+				while (i + 2 < nPoints && axis[i + 1] <= position)
+					++i;
+
+				block.index[k] = static_cast<int32_t>(i);
+			}
+
+			fractions(axis.data(), first, interval, nInBlock, block, simdLevel);
+
+			for (size_t c = 0; c < nColumns; ++c)
+				interpolate(columns[c].from, block, nInBlock, columns[c].to + first, simdLevel);
+		}
+	}
+
+	void writeGrid(double *out, size_t nSamples, double interval)
+	{
+		for (size_t k = 0; k < nSamples; ++k)
+			out[k] = samplePosition(k, interval);
+	}
+
+	// The columns to interpolate from the points, other than the grid's own axis
+	std::array<ColumnToResample, 4> gpxColumnsToResample(const std::vector<GpxPoint> &gpxData, const ResampledColumns &columns,
+		const AlignedVector<double> &otherAxis, double *otherAxisOut, size_t &nColumns)
+	{
+		// Indices are scaled by the stride as 32 bit ints
+		if (gpxData.size() > (size_t(INT32_MAX) >> GPX_POINT_STRIDE_SHIFT))
+			throw std::invalid_argument("Too many points to resample");
+
+		std::array<ColumnToResample, 4> toResample = {};
+		nColumns = 0;
+
+		const auto add = [&toResample, &nColumns](const double *from, int strideShift, double *to)
+		{
+			if (to)
+				toResample[nColumns++] = { { from, strideShift }, to };
+		};
+
+		add(otherAxis.data(), 0, otherAxisOut);
+		if (!gpxData.empty())
+		{
+			add(&gpxData.front().longitude, GPX_POINT_STRIDE_SHIFT, columns.longitude);
+			add(&gpxData.front().latitude, GPX_POINT_STRIDE_SHIFT, columns.latitude);
+			add(&gpxData.front().elevation_m, GPX_POINT_STRIDE_SHIFT, columns.elevation_m);
+		}
+
+		return toResample;
+	}
+}
+
+TrackResampler::TrackResampler() :
+	TrackResampler(detectSimdLevel())
+{
+}
+
+TrackResampler::TrackResampler(SimdLevel simdLevel) :
+	simdLevel(simdLevel)
+{
+}
+
+void TrackResampler::calculateTimes(const std::vector<GpxPoint> &gpxData)
+{
+	time_s.resize(gpxData.size());
+	for (size_t i = 0; i < gpxData.size(); ++i)
+		time_s[i] = static_cast<double>(static_cast<int64_t>(gpxData[i].dateTime_ms - gpxData.front().dateTime_ms)) / 1000.0;
+}
+
+void TrackResampler::calculateDistances(const std::vector<GpxPoint> &gpxData)
+{
+	distance_m.resize(gpxData.size());
+	calculateStepDistances(gpxData.data(), gpxData.size(), distance_m.data(), simdLevel);
+	std::partial_sum(distance_m.begin(), distance_m.end(), distance_m.begin());
+}
+
+size_t TrackResampler::resampleOnTime(const std::vector<GpxPoint> &gpxData, double interval_s, const ResampledColumns &columns)
+{
+	checkInterval(interval_s);
+
+	calculateTimes(gpxData);
+	const auto nSamples = sampleCount(time_s, interval_s);
+	if (nSamples > columns.capacity)
+		return nSamples;
+
+	if (columns.distance_m)
+		calculateDistances(gpxData);
+
+	size_t nColumns;
+	const auto toResample = gpxColumnsToResample(gpxData, columns, distance_m, columns.distance_m, nColumns);
+	resampleColumns(time_s, interval_s, nSamples, toResample, nColumns, simdLevel);
+
+	if (columns.time_s)
+		writeGrid(columns.time_s, nSamples, interval_s);
+
+	return nSamples;
+}
+
+size_t TrackResampler::resampleOnDistance(const std::vector<GpxPoint> &gpxData, double interval_m, const ResampledColumns &columns)
+{
+	checkInterval(interval_m);
+
+	calculateDistances(gpxData);
+	const auto nSamples = sampleCount(distance_m, interval_m);
+	if (nSamples > columns.capacity)
+		return nSamples;
+
+	if (columns.time_s)
+		calculateTimes(gpxData);
+
+	size_t nColumns;
+	const auto toResample = gpxColumnsToResample(gpxData, columns, time_s, columns.time_s, nColumns);
+	resampleColumns(distance_m, interval_m, nSamples, toResample, nColumns, simdLevel);
+
+	if (columns.distance_m)
+		writeGrid(columns.distance_m, nSamples, interval_m);
+
+	return nSamples;
+}
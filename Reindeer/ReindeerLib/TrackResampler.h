@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+#include "ActivityStructures.h"
+#include "AlignedVector.h"
+#include "SimdDispatch.h"
+
+namespace reindeer
+{
+	// Caller owned output columns, each with room for capacity samples
+	// Columns left as nullptr aren't written
+	struct ResampledColumns
+	{
+		// Since the first point
+		double *time_s = nullptr;
+		double *distance_m = nullptr;
+
+		double *longitude = nullptr;
+		double *latitude = nullptr;
+		double *elevation_m = nullptr;
+
+		size_t capacity = 0;
+	};
+
+	// Linearly interpolates a track onto a fixed interval grid of time or distance, from the first point up to the last
+	// Samples are done in blocks: the grid is walked to find each sample's pair of points, then every column is interpolated in SIMD lanes
+	// Keeps its per point scratch between calls, so resampling many activities with one resampler doesn't allocate per activity
+	// A sample where the grid's axis doesn't advance (e.g. a stop, on the distance grid) takes the last point there
+	// Point times should be in increasing order
+	class TrackResampler
+	{
+	public:
+		// Uses the best SIMD level the CPU supports
+		TrackResampler();
+
+		// Uses a particular SIMD level, which must be supported
+		explicit TrackResampler(SimdLevel simdLevel);
+
+		// Both return the number of samples, and only write them if they fit in the columns' capacity
+		// (so passing no capacity gives the size to allocate)
+		// Throw std::invalid_argument if the interval isn't positive
+		size_t resampleOnTime(const std::vector<GpxPoint> &gpxData, double interval_s, const ResampledColumns &columns);
+		size_t resampleOnDistance(const std::vector<GpxPoint> &gpxData, double interval_m, const ResampledColumns &columns);
+
+	private:
+		const SimdLevel simdLevel;
+
+		// Running totals at each point
+		AlignedVector<double> time_s;
+		AlignedVector<double> distance_m;
+
+		void calculateTimes(const std::vector<GpxPoint> &gpxData);
+		void calculateDistances(const std::vector<GpxPoint> &gpxData);
+	};
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace reindeer
+{
+	// Hands frames from one writer thread to one reader thread without locks
+	// The writer fills back() and publish() swaps it with the spare buffer, while latest() swaps the spare
+	// with the reader's front buffer when a newer frame has been published
+	// Neither side ever waits for the other, and the reader's frame isn't touched until it next calls latest()
+	template <typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer() = default;
+
+		TripleBuffer(const TripleBuffer &) = delete;
+		TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+		// Writer only: the buffer to fill for the next frame
+		// It holds an old frame (or a default T), so reuse its allocations rather than relying on its contents
+		T &back()
+		{
+			return buffers[backIndex];
+		}
+
+		// Writer only: the frame most recently published
+		// The reader may be reading it too, so it must not be changed
+		const T &lastPublished() const
+		{
+			return buffers[lastPublishedIndex];
+		}
+
+		// Writer only: makes back() the latest frame, and gives the writer a new back buffer
+		void publish()
+		{
+			lastPublishedIndex = backIndex;
+			backIndex = spare.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel) & INDEX_MASK;
+		}
+
+		// Reader only: the latest published frame (or a default T if none has been), unchanged until the next call
+		const T &latest()
+		{
+			if (spare.load(std::memory_order_relaxed) & FRESH)
+				frontIndex = spare.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+
+			return buffers[frontIndex];
+		}
+
+	private:
+		static constexpr uint8_t INDEX_MASK = 0x3;
+		static constexpr uint8_t FRESH = 0x4;
+
+		std::array<T, 3> buffers;
+
+		// The spare buffer's index, and FRESH if it holds a frame the reader hasn't taken yet
+		std::atomic<uint8_t> spare{ 1 };
+
+		// Only used by the writer
+		uint8_t backIndex = 0;
+		uint8_t lastPublishedIndex = 2;
+
+		// Only used by the reader
+		uint8_t frontIndex = 2;
+	};
+}